@@ -0,0 +1,47 @@
+#include "LogDecimator.hpp"
+
+void LogDecimator::configure(float idleHz, float preRollS) {
+  m_idleIntervalUs = (idleHz > 0.0f) ? (uint64_t)(1e6f / idleHz) : UINT64_MAX;
+  m_preRollUs = (preRollS > 0.0f) ? (uint64_t)(preRollS * 1e6f) : 0;
+  m_haveKept = false;
+}
+
+size_t LogDecimator::select(const SpscRing &ring, size_t count, bool flush, uint8_t *keep) {
+  auto header = [&](size_t i) { return reinterpret_cast<const SampleRecordHeader *>(ring.at(i)); };
+  size_t available = ring.size();
+  if (count == 0 || available < count) return 0;
+
+  // Nearest full rate record past the block, only looked for as far as a pre-roll reaches
+  uint64_t lastUs = header(count - 1)->timestamp;
+  uint64_t nextFullUs = UINT64_MAX;
+  for (size_t i = count; i < available; ++i) {
+    const SampleRecordHeader *h = header(i);
+    if (h->timestamp - lastUs > m_preRollUs) break;
+    if (!(h->flags & RECORD_FLAG_QUIET)) {
+      nextFullUs = h->timestamp;
+      break;
+    }
+  }
+
+  // Walking back, a record is written in full if it or one within a pre-roll after it is
+  for (size_t i = count; i-- > 0;) {
+    const SampleRecordHeader *h = header(i);
+    if (!(h->flags & RECORD_FLAG_QUIET)) nextFullUs = h->timestamp;
+    keep[i] = (nextFullUs != UINT64_MAX && nextFullUs - h->timestamp <= m_preRollUs);
+  }
+
+  // Then forwards, quiet records left out unless one is due at the idle rate. Stop at the first
+  // record without a full pre-roll behind it
+  uint64_t newestUs = header(available - 1)->timestamp;
+  bool settleAll = flush || available > ring.capacity() / 2;
+  for (size_t i = 0; i < count; ++i) {
+    uint64_t timestampUs = header(i)->timestamp;
+    if (!settleAll && newestUs - timestampUs < m_preRollUs) return i;
+    if (!keep[i] && (!m_haveKept || timestampUs - m_lastKeptUs >= m_idleIntervalUs)) keep[i] = 1;
+    if (keep[i]) {
+      m_lastKeptUs = timestampUs;
+      m_haveKept = true;
+    }
+  }
+  return count;
+}
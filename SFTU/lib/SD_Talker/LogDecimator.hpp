@@ -0,0 +1,28 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "SD_Talker.hpp"
+#include "SpscRing.hpp"
+
+// Thins quiet records (RECORD_FLAG_QUIET) in the sample ring down to an idle rate on their way to the
+// log, while everything else is written in full. A record is only decided once a pre-roll's worth of
+// newer ones has arrived behind it, so the quiet records leading up to an excursion are still written
+// in full and the leading edge isn't lost. Works on the records in place, SD task only.
+class LogDecimator {
+ public:
+  // Keep one quiet record per 1 / idleHz seconds (none if idleHz <= 0) and preRollS of them ahead of
+  // any full rate record. Starts a fresh log, the next quiet record is always kept
+  void configure(float idleHz, float preRollS);
+
+  // Set keep[i] for which of the `count` oldest records in `ring` to write. Returns how many of those
+  // are decided and can be released, the rest wait for their pre-roll. `flush` decides them all, for
+  // when no more records will arrive. The pre-roll is also cut short once the ring is half full
+  size_t select(const SpscRing &ring, size_t count, bool flush, uint8_t *keep);
+
+ private:
+  uint64_t m_idleIntervalUs = 0;
+  uint64_t m_preRollUs = 0;
+  uint64_t m_lastKeptUs = 0;
+  bool m_haveKept = false;
+};
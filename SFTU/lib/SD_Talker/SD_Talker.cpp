@@ -54,6 +54,13 @@ bool SD_Talker::checkPresence() {
 
 bool SD_Talker::checkFileOpen() { return m_fileOpen; }
 
+void SD_Talker::closeFile() {
+  if (!m_fileOpen) return;
+  dataFile.close();
+  m_fileOpen = false;
+  ESP_LOGI(TAG, "Closed file: %s", fileName.c_str());
+}
+
 // seems to be working
 bool SD_Talker::sdWait(int timeout) {
   uint8_t response;
@@ -257,8 +264,7 @@ String SD_Talker::createUniqueLogFile(String prefix) {
   return uniqueFileName;
 }
 
-// New overload for value+timestamp
-bool SD_Talker::writeBlockToSD(const SampleWithTimestamp *block, size_t count) {
+bool SD_Talker::writeBlockToSD(const uint8_t *block, size_t count, const SampleLayout &layout) {
   if (!m_fileOpen) {
     ESP_LOGE("SD_Talker", "Attempted to write to SD card, but file is not open.");
     return false;
@@ -270,12 +276,7 @@ bool SD_Talker::writeBlockToSD(const SampleWithTimestamp *block, size_t count) {
 
   // Buffer the entire block as a String and write in one go
   String buffer;
-  buffer.reserve(count * 140);  // Increased estimate for battery voltage column
-  for (size_t i = 0; i < count; ++i) {
-    char line[144];  // HACK: Increased buffer size for battery voltage
-    snprintf(line, sizeof(line), "%llu,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f\n", (unsigned long long)block[i].timestamp, block[i].value1, block[i].value2, block[i].value3, block[i].value4, block[i].value5, block[i].value6, block[i].value7, block[i].value8, block[i].battery_voltage);
-    buffer += line;
-  }
+  formatRecords(buffer, block, count, layout);
   size_t bytesWritten = dataFile.print(buffer);
   dataFile.flush();
   if (bytesWritten != buffer.length()) {
@@ -285,16 +286,97 @@ bool SD_Talker::writeBlockToSD(const SampleWithTimestamp *block, size_t count) {
   return true;
 }
 
+void SD_Talker::formatRecords(String &buffer, const uint8_t *block, size_t count, const SampleLayout &layout) {
+  // Estimate including battery voltage and channel offset columns
+  buffer.reserve(buffer.length() + count * (40 + (layout.numChannels + layout.numDerived) * 20));
+  for (size_t i = 0; i < count; ++i) {
+    char line[384];
+    const uint8_t *record = block + i * layout.recordSize;
+    const SampleRecordHeader *header = reinterpret_cast<const SampleRecordHeader *>(record);
+    const uint16_t *offsetsUs = layout.offsetsUs(record);
+
+    int len = snprintf(line, sizeof(line), "%llu", (unsigned long long)header->timestamp);
+    for (int slot = 0; slot < layout.numChannels; ++slot) {
+      // Channels that weren't due on this tick are left as empty cells. Units are only worked out here
+      if (header->slotMask & (1 << slot)) {
+        float units = layout.getCount(record, slot) * layout.unitsPerCount[slot] - layout.unitsOffset[slot];
+        if (layout.curve[slot]) units = layout.curve[slot]->evaluate(units);
+        len += snprintf(line + len, sizeof(line) - len, ",%.6f", units);
+      } else {
+        len += snprintf(line + len, sizeof(line) - len, ",");
+      }
+    }
+    const float *derived = layout.derived(record);
+    for (int d = 0; d < layout.numDerived; ++d) {
+      len += snprintf(line + len, sizeof(line) - len, ",%.6f", derived[d]);
+    }
+    len += snprintf(line + len, sizeof(line) - len, ",%.6f", header->battery_voltage);
+    for (int slot = 0; slot < layout.numChannels; ++slot) {
+      if (header->slotMask & (1 << slot)) {
+        len += snprintf(line + len, sizeof(line) - len, ",%u", offsetsUs[slot]);
+      } else {
+        len += snprintf(line + len, sizeof(line) - len, ",");
+      }
+    }
+    snprintf(line + len, sizeof(line) - len, ",%u\n", (header->flags & RECORD_FLAG_PRE_TARE) ? 1 : 0);
+    buffer += line;
+  }
+}
+
+String SD_Talker::buildHeader(const std::vector<String> &channelNames, const std::vector<String> &channelUnits) {
+  String header = "Time(us)";
+  for (size_t i = 0; i < channelNames.size(); ++i) {
+    header += ", " + channelNames[i] + "(" + channelUnits[i] + ")";
+  }
+  return header;
+}
+
+bool SD_Talker::writeSnapshot(String filePrefix, const String &note, const std::vector<String> &channelNames, const std::vector<String> &channelUnits, const uint8_t *const spans[2], const size_t counts[2], const SampleLayout &layout) {
+  if (!m_initialised || !checkPresence()) {
+    return false;
+  }
+
+  String snapshotName = createUniqueLogFile(filePrefix);
+  if (snapshotName.isEmpty()) return false;
+
+  // Separate handle so the running log stays open
+  File snapshotFile = SD.open(snapshotName.c_str(), FILE_WRITE);
+  if (!snapshotFile) {
+    ESP_LOGE(TAG, "Failed to create snapshot file %s", snapshotName.c_str());
+    return false;
+  }
+
+  snapshotFile.println("# " + note);
+  snapshotFile.println(buildHeader(channelNames, channelUnits));
+
+  // Format in chunks so a long capture doesn't need one huge String
+  constexpr size_t chunkSize = 256;
+  bool success = true;
+  for (int part = 0; part < 2 && success; ++part) {
+    for (size_t done = 0; done < counts[part] && success; done += chunkSize) {
+      size_t n = std::min(chunkSize, counts[part] - done);
+      String buffer;
+      formatRecords(buffer, spans[part] + done * layout.recordSize, n, layout);
+      success = snapshotFile.print(buffer) == buffer.length();
+    }
+  }
+  snapshotFile.close();
+
+  if (success) {
+    ESP_LOGI(TAG, "Wrote %u records to %s", (unsigned)(counts[0] + counts[1]), snapshotName.c_str());
+  } else {
+    ESP_LOGE(TAG, "Failed to write all bytes to %s", snapshotName.c_str());
+  }
+  return success;
+}
+
 bool SD_Talker::startNewLog(String filePrefix, const std::vector<String> &channelNames, const std::vector<String> &channelUnits) {
   if (!m_initialised || !checkPresence()) {
     return false;
   }
 
   // TODO: Set these with config file
-  String startMsg = "Time(us)";
-  for (size_t i = 0; i < channelNames.size(); ++i) {
-    startMsg += ", " + channelNames[i] + "(" + channelUnits[i] + ")";
-  }
+  String startMsg = buildHeader(channelNames, channelUnits);
 
   if (createFile(startMsg, filePrefix)) {
     ESP_LOGI(TAG, "Created file on SD card!");
@@ -3,21 +3,103 @@
 #include <SD.h>
 
 #include "Arduino.h"
+#include "CalibrationCurve.hpp"
+#include "DerivedChannels.hpp"
 #include "esp_log.h"
 
+// Counts of channels logged at 32 bits (see ChannelConfig::wideCounts) carry this many bits below the
+// ADS1115 LSB (or the oversampled sum's), so decimation and the filters keep the resolution they add
+// instead of rounding it away. The channel's lsbV includes it
+static constexpr int COUNT_FRACTION_BITS = 4;
+
+// Full 8-channel view of a sample, used for the latest value shown on the display and in telemetry.
+// Channels are raw ADS1115 counts (summed when oversampled, and after any filtering), with
+// COUNT_FRACTION_BITS of fraction on 32 bit channels; convert with a ChannelConverter where units are needed.
 typedef struct {
-  float value1;
-  float value2;
-  float value3;
-  float value4;
-  float value5;
-  float value6;
-  float value7;
-  float value8;
+  uint64_t timestamp;  // scan start, us since the first sample
+  int32_t counts[8];
   float battery_voltage;
-  uint32_t timestamp;
+  uint16_t channelOffsetUs[8];  // when each channel's conversion completed, us after timestamp
+  uint8_t channelMask;  // bit n set when counts[n] was sampled on this tick
+  uint8_t flags;        // RECORD_FLAG_*
+  float derived[DerivedChannels::MAX_CHANNELS];  // in units, already worked out by the analog task
 } SampleWithTimestamp;
 
+// Logged before the auto-tare offsets were fixed, units on these rows may not be zeroed
+static constexpr uint8_t RECORD_FLAG_PRE_TARE = 1 << 0;
+// Every channel was inside its quiet band, adaptive logging may leave the record out (see LogDecimator)
+static constexpr uint8_t RECORD_FLAG_QUIET = 1 << 1;
+
+// Fixed start of a packed sample record, as carried in the sample ring and written to SD.
+// It is followed by float derived[numDerived], then the counts and uint16_t offsetsUs[numChannels] for
+// the active channels only, and padded so the next record's timestamp stays 8 byte aligned. A plain
+// channel's counts are int16_t; oversampled, auto-ranged and filtered ones need int32_t, and those go
+// first so they stay 4 byte aligned.
+typedef struct {
+  uint64_t timestamp;  // scan start, us since the first sample
+  float battery_voltage;
+  uint8_t slotMask;  // bit n set when slot n was sampled on this tick
+  uint8_t flags;     // RECORD_FLAG_*
+} SampleRecordHeader;
+
+// Which channels a packed record carries, derived from the config at setup, and how to turn each
+// slot's counts into units. 5 plain channels pack into 40 bytes and all 8 into 48, the same as and 8
+// more than the old fixed record of a 32 bit timestamp and 9 floats, with a 64 bit timestamp and the
+// conversion times on top. Each 32 bit channel adds 2 bytes before padding.
+struct SampleLayout {
+  uint8_t numChannels = 0;
+  uint8_t channel[8] = {0};  // channel index (0-7) held in each slot
+  uint8_t wideMask = 0;      // slots whose counts are int32_t
+  uint8_t numDerived = 0;    // set before adding channels
+  uint16_t countAt[8] = {0};  // byte offset of each slot's count in the record
+  uint16_t offsetsAt = sizeof(SampleRecordHeader);
+  size_t recordSize = sizeof(SampleRecordHeader);
+
+  // units = counts * unitsPerCount - unitsOffset. Filled in by whoever formats the records
+  float unitsPerCount[8] = {0};
+  float unitsOffset[8] = {0};
+  // Non-null for channels with a calibration curve, which then takes the linear result as tared volts
+  const CalibrationCurve *curve[8] = {nullptr};
+
+  void addChannel(uint8_t idx, bool wide) {
+    if (wide) wideMask |= (1 << numChannels);
+    channel[numChannels++] = idx;
+    size_t at = countsAt();
+    for (int slot = 0; slot < numChannels; ++slot) {
+      if (!(wideMask & (1 << slot))) continue;
+      countAt[slot] = at;
+      at += sizeof(int32_t);
+    }
+    for (int slot = 0; slot < numChannels; ++slot) {
+      if (wideMask & (1 << slot)) continue;
+      countAt[slot] = at;
+      at += sizeof(int16_t);
+    }
+    offsetsAt = at;
+    size_t size = at + numChannels * sizeof(uint16_t);
+    recordSize = (size + alignof(uint64_t) - 1) & ~(alignof(uint64_t) - 1);
+  }
+
+  // Derived values come straight after the header, the counts after them stay 4 byte aligned
+  size_t countsAt() const { return sizeof(SampleRecordHeader) + numDerived * sizeof(float); }
+  float *derived(uint8_t *record) const { return reinterpret_cast<float *>(record + sizeof(SampleRecordHeader)); }
+  const float *derived(const uint8_t *record) const { return reinterpret_cast<const float *>(record + sizeof(SampleRecordHeader)); }
+
+  int32_t getCount(const uint8_t *record, int slot) const {
+    if (wideMask & (1 << slot)) return *reinterpret_cast<const int32_t *>(record + countAt[slot]);
+    return *reinterpret_cast<const int16_t *>(record + countAt[slot]);
+  }
+  void setCount(uint8_t *record, int slot, int32_t value) const {
+    if (wideMask & (1 << slot)) {
+      *reinterpret_cast<int32_t *>(record + countAt[slot]) = value;
+    } else {
+      *reinterpret_cast<int16_t *>(record + countAt[slot]) = (int16_t)std::min<int32_t>(std::max<int32_t>(value, INT16_MIN), INT16_MAX);
+    }
+  }
+  uint16_t *offsetsUs(uint8_t *record) const { return reinterpret_cast<uint16_t *>(record + offsetsAt); }
+  const uint16_t *offsetsUs(const uint8_t *record) const { return reinterpret_cast<const uint16_t *>(record + offsetsAt); }
+};
+
 class SD_Talker {
  public:
   SD_Talker();
@@ -34,7 +116,9 @@ class SD_Talker {
   String createUniqueLogFile(String prefix) { return "true"; }
   bool createNestedDirectories(String prefix) { return true; }
   bool checkPresence() { return true; }
-  bool writeBlockToSD(const float *block, size_t count) { return true; }
+  void closeFile() {}
+  bool writeBlockToSD(const uint8_t *block, size_t count, const SampleLayout &layout) { return true; }
+  bool writeSnapshot(String filePrefix, const String &note, const std::vector<String> &channelNames, const std::vector<String> &channelUnits, const uint8_t *const spans[2], const size_t counts[2], const SampleLayout &layout) { return true; }
 
 #else
   bool checkStatus();
@@ -49,12 +133,20 @@ class SD_Talker {
   bool createNestedDirectories(String prefix);
   bool checkPresence();
   bool checkFileOpen();
-  // New overload for value+timestamp
-  bool writeBlockToSD(const SampleWithTimestamp *block, size_t count);
+  // Finish the running log, the next startNewLog() opens a new one
+  void closeFile();
+  // Write `count` packed records laid out as described by `layout`
+  bool writeBlockToSD(const uint8_t *block, size_t count, const SampleLayout &layout);
   // bool startNewLog(String filePrefix);
   bool startNewLog(String filePrefix, const std::vector<String> &channelNames, const std::vector<String> &channelUnits);
+  // Write a standalone file of packed records (given as up to two spans) next to the running log.
+  // `note` goes on a comment line above the header.
+  bool writeSnapshot(String filePrefix, const String &note, const std::vector<String> &channelNames, const std::vector<String> &channelUnits, const uint8_t *const spans[2], const size_t counts[2], const SampleLayout &layout);
 
  private:
+  static String buildHeader(const std::vector<String> &channelNames, const std::vector<String> &channelUnits);
+  void formatRecords(String &buffer, const uint8_t *block, size_t count, const SampleLayout &layout);
+
   File dataFile;
   String fileName;
   String buffer;
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <atomic>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Single-writer snapshot. The writer never waits; readers copy the value and retry if the
+// writer was part way through an update. Only suitable for small trivially copyable types.
+template <typename T>
+class SeqLock {
+ public:
+  void write(const T &value) {
+    uint32_t seq = m_seq.load(std::memory_order_relaxed);
+    m_seq.store(seq + 1, std::memory_order_relaxed);  // odd while the update is in progress
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy((void *)&m_value, &value, sizeof(T));
+    m_seq.store(seq + 2, std::memory_order_release);
+  }
+
+  void read(T &value) {
+    uint32_t spins = 0;
+    while (true) {
+      uint32_t before = m_seq.load(std::memory_order_acquire);
+      if ((before & 1) == 0) {
+        memcpy(&value, (const void *)&m_value, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_seq.load(std::memory_order_relaxed) == before) break;
+      }
+      m_retries.fetch_add(1, std::memory_order_relaxed);
+      // The writer may have been preempted mid-update, give it a chance to finish
+      if (++spins % 16 == 0) vTaskDelay(1);
+    }
+    m_reads.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  uint32_t reads() const { return m_reads.load(std::memory_order_relaxed); }
+  uint32_t retries() const { return m_retries.load(std::memory_order_relaxed); }
+  void resetStats() {
+    m_reads.store(0, std::memory_order_relaxed);
+    m_retries.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<uint32_t> m_seq{0};
+  volatile T m_value = {};
+
+  std::atomic<uint32_t> m_reads{0};
+  std::atomic<uint32_t> m_retries{0};
+};
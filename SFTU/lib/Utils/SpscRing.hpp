@@ -0,0 +1,112 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <atomic>
+#include <new>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Lock-free ring of fixed size records for exactly one producer task and one consumer task.
+// The record size is chosen at runtime so the storage matches whatever the producer actually
+// writes. The producer fills a slot in place and commits it; the consumer reads contiguous spans
+// in place and releases them when done, so nothing is copied on either side.
+// When the ring is full new records are dropped and counted rather than blocking.
+class SpscRing {
+ public:
+  ~SpscRing() { delete[] m_buffer; }
+
+  // Allocate `capacity` (a power of two) records of `recordSize` bytes. Call before either side runs
+  bool begin(size_t capacity, size_t recordSize) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) return false;
+    delete[] m_buffer;
+    m_buffer = new (std::nothrow) uint8_t[capacity * recordSize];
+    if (m_buffer == nullptr) return false;
+    m_capacity = capacity;
+    m_mask = capacity - 1;
+    m_recordSize = recordSize;
+    m_head.store(0);
+    m_tail.store(0);
+    return true;
+  }
+
+  // Free the storage once neither side will touch the ring again
+  void end() {
+    delete[] m_buffer;
+    m_buffer = nullptr;
+    m_capacity = 0;
+  }
+
+  // Wake `consumer` with a task notification once `watermark` records are waiting
+  void setConsumer(TaskHandle_t consumer, size_t watermark) {
+    m_consumer = consumer;
+    m_watermark = watermark;
+  }
+
+  // Producer side: slot to fill for the next record, nullptr (and counted as dropped) if full
+  uint8_t *reserve() {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    size_t tail = m_tail.load(std::memory_order_acquire);
+    if (m_buffer == nullptr || head - tail >= m_capacity) {
+      m_dropped++;
+      return nullptr;
+    }
+    return &m_buffer[(head & m_mask) * m_recordSize];
+  }
+
+  // Producer side: publish the slot returned by the last reserve()
+  void commit() {
+    size_t head = m_head.load(std::memory_order_relaxed) + 1;
+    m_head.store(head, std::memory_order_release);
+
+    size_t count = head - m_tail.load(std::memory_order_acquire);
+    if (count > m_highWater) m_highWater = count;
+    if (m_consumer && count >= m_watermark && !m_notified.exchange(true)) {
+      xTaskNotifyGive(m_consumer);
+    }
+  }
+
+  // Consumer side: longest run of records readable without wrapping, 0 if empty
+  size_t peek(const uint8_t **span) {
+    m_notified.store(false);
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    size_t head = m_head.load(std::memory_order_acquire);
+    size_t count = head - tail;
+    if (count == 0) return 0;
+    size_t untilWrap = m_capacity - (tail & m_mask);
+    *span = &m_buffer[(tail & m_mask) * m_recordSize];
+    return (count < untilWrap) ? count : untilWrap;
+  }
+
+  // Consumer side: record `i` places after the oldest, for looking past the span from peek(). i < size()
+  const uint8_t *at(size_t i) const { return &m_buffer[((m_tail.load(std::memory_order_relaxed) + i) & m_mask) * m_recordSize]; }
+
+  // Consumer side: hand `count` records from the last peek() back to the producer
+  void release(size_t count) { m_tail.store(m_tail.load(std::memory_order_relaxed) + count, std::memory_order_release); }
+
+  size_t size() const { return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire); }
+  size_t capacity() const { return m_capacity; }
+  size_t recordSize() const { return m_recordSize; }
+  uint32_t dropped() const { return m_dropped; }
+  size_t highWater() const { return m_highWater; }
+  void resetStats() {
+    m_dropped = 0;
+    m_highWater = 0;
+  }
+
+ private:
+  uint8_t *m_buffer = nullptr;
+  size_t m_capacity = 0;
+  size_t m_mask = 0;
+  size_t m_recordSize = 0;
+  std::atomic<size_t> m_head{0};  // written by the producer only
+  std::atomic<size_t> m_tail{0};  // written by the consumer only
+  std::atomic<bool> m_notified{false};
+
+  TaskHandle_t m_consumer = nullptr;
+  size_t m_watermark = 0;
+
+  volatile uint32_t m_dropped = 0;
+  volatile size_t m_highWater = 0;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Notification bits used to wake the analog task. Each source sets its own bit with
+// xTaskNotifyFromISR(..., eSetBits) so several sources can share the one notification value.
+#define NOTIFY_ADS0_RDY (1UL << 0)
+#define NOTIFY_ADS1_RDY (1UL << 1)
+#define NOTIFY_SAMPLE_CLOCK (1UL << 2)
+
+// Block until every bit in `bits` has been notified or `timeout` expires.
+// Bits meant for other waiters are re-posted to the calling task so they aren't lost.
+inline bool taskNotifyWaitBits(uint32_t bits, TickType_t timeout) {
+  uint32_t received = 0;
+  TickType_t start = xTaskGetTickCount();
+
+  while ((received & bits) != bits) {
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    TickType_t remaining = (elapsed < timeout) ? (timeout - elapsed) : 0;
+
+    uint32_t value = 0;
+    if (xTaskNotifyWait(0, UINT32_MAX, &value, remaining) != pdTRUE) break;
+    received |= value;
+  }
+
+  uint32_t others = received & ~bits;
+  if (others) xTaskNotify(xTaskGetCurrentTaskHandle(), others, eSetBits);
+
+  return (received & bits) == bits;
+}
+
+// Discard any stale notification for `bits` without blocking
+inline void taskNotifyClearBits(uint32_t bits) { taskNotifyWaitBits(bits, 0); }
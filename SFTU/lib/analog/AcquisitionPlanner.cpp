@@ -0,0 +1,110 @@
+#include "AcquisitionPlanner.hpp"
+
+#include "adcADS.hpp"
+
+void AcquisitionPlanner::setChannels(const PlannerChannel channels[8], uint32_t stepOverheadUs) {
+  Channels next;
+  uint16_t maxOversample = 1;
+  for (int idx = 0; idx < 8; ++idx) {
+    next.channel[idx] = channels[idx];
+    if (channels[idx].active) maxOversample = std::max(maxOversample, channels[idx].oversample);
+  }
+  next.stepOverheadUs = stepOverheadUs;
+  next.maxDecimation = std::max(1, MAX_OVERSAMPLE / maxOversample);
+
+  portENTER_CRITICAL(&m_mux);
+  m_channels = next;
+  portEXIT_CRITICAL(&m_mux);
+}
+
+float AcquisitionPlanner::load(const Channels &channels, float logHz, uint16_t sps, uint16_t decimation, float busy[2]) {
+  float stepS = (adcADS::conversionUsAt(sps) + channels.stepOverheadUs) / 1e6f;
+  busy[0] = busy[1] = 0.0f;
+  for (int idx = 0; idx < 8; ++idx) {
+    const PlannerChannel &ch = channels.channel[idx];
+    if (!ch.active) continue;
+    float rate = (ch.sampleRate > 0.0f) ? ch.sampleRate : logHz;
+    busy[idx / 4] += rate * ch.oversample * decimation * stepS;
+  }
+  return std::max(busy[0], busy[1]);
+}
+
+float AcquisitionPlanner::maxLoadAt(const Channels &channels, uint16_t sps) {
+  float stepUs = adcADS::conversionUsAt(sps) + channels.stepOverheadUs;
+  float cpuStepUs = adcADS::timedSpinUsAt(sps) + channels.stepOverheadUs;
+  return std::min(MAX_LOAD, MAX_CPU_LOAD * stepUs / cpuStepUs);
+}
+
+bool AcquisitionPlanner::plan(float logHz, AcquisitionPlan &plan) const {
+  portENTER_CRITICAL(&m_mux);
+  Channels channels = m_channels;
+  portEXIT_CRITICAL(&m_mux);
+
+  plan = AcquisitionPlan();
+  plan.logHz = logHz;
+
+  // Each ADC's load is affine in logHz, so the ceiling at the fastest data rate falls straight out of it
+  uint16_t fastest = adcADS::dataRateSps(adcADS::NUM_DATA_RATES - 1);
+  float fixedLoad[2], oneHzLoad[2];
+  load(channels, 0.0f, fastest, 1, fixedLoad);
+  load(channels, 1.0f, fastest, 1, oneHzLoad);
+  for (int adc = 0; adc < 2; ++adc) {
+    float perHz = oneHzLoad[adc] - fixedLoad[adc];
+    if (perHz <= 0.0f) continue;
+    float maxHz = std::max(0.0f, (maxLoadAt(channels, fastest) - fixedLoad[adc]) / perHz);
+    plan.maxLogHz = (plan.maxLogHz > 0.0f) ? std::min(plan.maxLogHz, maxHz) : maxHz;
+  }
+
+  // Slowest rate first, so a tie goes to fewer conversions
+  bool found = false;
+  float bestUs = 0.0f;
+  for (size_t i = 0; i < adcADS::NUM_DATA_RATES; ++i) {
+    uint16_t sps = adcADS::dataRateSps(i);
+    float busy[2];
+    float single = load(channels, logHz, sps, 1, busy);
+    float maxLoad = maxLoadAt(channels, sps);
+    if (single > maxLoad * 1.0001f) continue;
+
+    uint16_t decimation = 1;
+    if (single > 0.0f) decimation = std::max(1, std::min<int>(channels.maxDecimation, (int)(maxLoad / single)));
+    float integratedUs = decimation * 1e6f / sps;
+    if (!found || integratedUs > bestUs) {
+      found = true;
+      bestUs = integratedUs;
+      plan.dataRateSps = sps;
+      plan.decimation = decimation;
+      plan.load = single * decimation;
+      plan.cpuLoad = plan.load * (adcADS::timedSpinUsAt(sps) + channels.stepOverheadUs) / (adcADS::conversionUsAt(sps) + channels.stepOverheadUs);
+    }
+  }
+  return found;
+}
+
+void AcquisitionPlanner::request(const AcquisitionPlan &plan) {
+  portENTER_CRITICAL(&m_mux);
+  m_request = plan;
+  m_pending = true;
+  portEXIT_CRITICAL(&m_mux);
+}
+
+bool AcquisitionPlanner::takeRequest(AcquisitionPlan &plan) {
+  portENTER_CRITICAL(&m_mux);
+  bool pending = m_pending;
+  if (pending) plan = m_request;
+  m_pending = false;
+  portEXIT_CRITICAL(&m_mux);
+  return pending;
+}
+
+void AcquisitionPlanner::setActive(const AcquisitionPlan &plan) {
+  portENTER_CRITICAL(&m_mux);
+  m_active = plan;
+  portEXIT_CRITICAL(&m_mux);
+}
+
+AcquisitionPlan AcquisitionPlanner::active() {
+  portENTER_CRITICAL(&m_mux);
+  AcquisitionPlan plan = m_active;
+  portEXIT_CRITICAL(&m_mux);
+  return plan;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "freertos/FreeRTOS.h"
+
+// What one channel asks of the acquisition loop, as far as planning goes
+struct PlannerChannel {
+  bool active = false;
+  float sampleRate = 0.0f;  // its own log rate in Hz, 0 to follow the plan's
+  uint16_t oversample = 1;  // conversions summed into each logged sample, from the config
+};
+
+// How to run both ADCs for a given log rate
+struct AcquisitionPlan {
+  float logHz = 0.0f;          // rate for channels without their own sample_rate
+  uint16_t dataRateSps = 860;  // ADS1115 data rate, both ADCs convert in step
+  uint16_t decimation = 1;     // conversions averaged into each logged sample, on top of the channel's oversampling
+  float load = 0.0f;           // busiest ADC's share of its time spent converting and on the bus
+  float cpuLoad = 0.0f;        // analog task's share of its core, on the bus or spinning out a conversion
+  float maxLogHz = 0.0f;       // fastest logHz the active channels allow, 0 if none follow it
+};
+
+// Picks the ADS1115 data rate and decimation for a requested log rate. A conversion's noise falls
+// with the time it integrates over, whether that is one slow conversion or several fast ones
+// averaged, so the plan with the most integration time per logged sample that still fits the scan
+// budget wins. Fast conversions spend more of that budget on I2C, which is why the slowest data rate
+// that fits normally comes out on top and decimation only helps once even 8 SPS leaves time spare.
+// Waiting out a conversion mostly sleeps, but the bus time and the part of a tick the wait spins
+// take the analog task's core, and that is capped separately so the other tasks on it keep running.
+// Any task can plan; an accepted plan is handed to the analog task to apply between scans.
+class AcquisitionPlanner {
+ public:
+  static constexpr float MAX_LOAD = 0.85f;         // room for scan jitter and the odd slow transaction
+  static constexpr float MAX_CPU_LOAD = 0.6f;      // the SD and status tasks share the analog core
+  static constexpr uint16_t MAX_OVERSAMPLE = 256;  // channel oversampling times decimation
+
+  // Call before anything plans, and again when the channels change. `stepOverheadUs` is the I2C
+  // time around each conversion
+  void setChannels(const PlannerChannel channels[8], uint32_t stepOverheadUs);
+
+  // Best plan for `logHz`. False, with plan.maxLogHz filled in, when no data rate keeps up
+  bool plan(float logHz, AcquisitionPlan &plan) const;
+
+  // Queue a plan from plan() for the analog task
+  void request(const AcquisitionPlan &plan);
+  // Analog task: the queued plan, if any. Publish it with setActive() once applied
+  bool takeRequest(AcquisitionPlan &plan);
+  void setActive(const AcquisitionPlan &plan);
+  AcquisitionPlan active();
+
+ private:
+  struct Channels {
+    PlannerChannel channel[8];
+    uint32_t stepOverheadUs = 0;
+    uint16_t maxDecimation = 1;
+  };
+
+  // Each ADC's share of its time at the given settings, returns the busier one
+  static float load(const Channels &channels, float logHz, uint16_t sps, uint16_t decimation, float busy[2]);
+  // Highest ADC load a plan at `sps` can run at, the CPU cap turned into an ADC load. Both ADCs convert
+  // in step, so the core is busy for the same share of each step as the busier ADC is
+  static float maxLoadAt(const Channels &channels, uint16_t sps);
+
+  mutable portMUX_TYPE m_mux = portMUX_INITIALIZER_UNLOCKED;
+  Channels m_channels;  // planners copy this out under the lock, it changes with a config reload
+  AcquisitionPlan m_request;
+  bool m_pending = false;
+  AcquisitionPlan m_active;
+
+  static constexpr const char *TAG = "AcquisitionPlanner";
+};
@@ -0,0 +1,26 @@
+#include "AutoTare.hpp"
+
+void AutoTare::restart(uint8_t channelMask, uint8_t tareMask, uint32_t samples) {
+  tareMask &= channelMask;
+  for (size_t i = 0; i < NUM_CHANNELS; ++i) {
+    if (tareMask & (1 << i)) m_stats[i] = Stats();
+  }
+  m_pendingMask = (samples > 0) ? (m_pendingMask & ~channelMask) | tareMask : 0;
+  m_samples = samples;
+}
+
+uint8_t AutoTare::feed(const int32_t *counts, uint8_t mask) {
+  uint8_t done = 0;
+  for (uint8_t active = m_pendingMask & mask; active; active &= active - 1) {
+    size_t i = __builtin_ctz(active);
+    Stats &s = m_stats[i];
+    float x = (float)counts[i];
+    s.count++;
+    float delta = x - s.mean;
+    s.mean += delta / s.count;
+    s.m2 += delta * (x - s.mean);
+    if (s.count >= m_samples) done |= (1 << i);
+  }
+  m_pendingMask &= ~done;
+  return done;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Streaming zero offset for every auto-tare channel at once, worked out from the first samples of
+// the normal acquisition loop instead of blocking reads before it starts. Welford's running mean
+// and variance per channel, so the spread of the tare window is reported alongside the offset.
+// Analog task only.
+class AutoTare {
+ public:
+  static constexpr size_t NUM_CHANNELS = 8;
+
+  // Channels in `channelMask` stop averaging, and the ones also in `tareMask` start over on the next
+  // `samples` samples. Pending channels outside `channelMask` carry on where they were
+  void restart(uint8_t channelMask, uint8_t tareMask, uint32_t samples);
+
+  // Returns the channels whose offset was fixed by this sample
+  uint8_t feed(const int32_t *counts, uint8_t mask);
+
+  bool pending() const { return m_pendingMask != 0; }
+  uint8_t pendingMask() const { return m_pendingMask; }
+  float mean(size_t idx) const { return m_stats[idx].mean; }
+  float stddev(size_t idx) const { return m_stats[idx].count > 1 ? sqrtf(m_stats[idx].m2 / (m_stats[idx].count - 1)) : 0.0f; }
+
+ private:
+  struct Stats {
+    uint32_t count = 0;
+    float mean = 0.0f;
+    float m2 = 0.0f;  // sum of squared differences from the mean
+  };
+
+  Stats m_stats[NUM_CHANNELS];
+  uint8_t m_pendingMask = 0;
+  uint32_t m_samples = 0;
+};
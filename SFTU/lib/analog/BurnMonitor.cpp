@@ -0,0 +1,87 @@
+#include "BurnMonitor.hpp"
+
+void BurnMonitor::feed(uint64_t timestampUs, bool haveThrust, float thrust, bool havePressure, float pressure) {
+  uint8_t requests = m_requests.load(std::memory_order_relaxed) ? m_requests.exchange(0, std::memory_order_acq_rel) : 0;
+  if (requests & REQUEST_START) {
+    m_state = State::ARMED;
+    m_ending = false;
+    m_stopped = false;
+    m_startUs = timestampUs;
+    m_above = false;
+    m_impulse = m_impulseAtLastAbove = 0.0f;
+    m_peakThrust = 0.0f;
+    m_havePressure = false;
+    m_peakPressure = 0.0f;
+  }
+  if ((requests & REQUEST_END) && m_state != State::IDLE && !m_ending) {
+    m_ending = true;
+    m_stopped = requests & REQUEST_STOPPED;
+    m_endUs = timestampUs;
+  }
+  if (m_state == State::IDLE) return;
+
+  if (havePressure && (!m_havePressure || pressure > m_peakPressure)) {
+    m_peakPressure = pressure;
+    m_havePressure = true;
+  }
+
+  if (haveThrust) {
+    m_above = thrust > m_threshold;
+    if (m_state == State::ARMED && m_above) {
+      m_state = State::BURNING;
+      m_ignitionUs = timestampUs;
+      m_peakThrust = thrust;
+      m_peakThrustUs = timestampUs;
+      ESP_LOGI(TAG, "Ignition, thrust %.2f", thrust);
+    } else if (m_state == State::BURNING) {
+      m_impulse += 0.5f * (thrust + m_lastThrust) * ((timestampUs - m_lastThrustUs) / 1e6f);
+      if (thrust > m_peakThrust) {
+        m_peakThrust = thrust;
+        m_peakThrustUs = timestampUs;
+      }
+    }
+    if (m_state == State::BURNING && m_above) {
+      m_lastAboveUs = timestampUs;
+      m_impulseAtLastAbove = m_impulse;
+    }
+    m_lastThrust = thrust;
+    m_lastThrustUs = timestampUs;
+  }
+
+  // The sequence may end while the motor is still tailing off, give it a moment to drop below the threshold
+  if (m_ending && (!(m_state == State::BURNING && m_above) || timestampUs - m_endUs >= END_GRACE_US)) finish();
+}
+
+void BurnMonitor::finish() {
+  Summary summary = {};
+  summary.burnDetected = m_state == State::BURNING;
+  summary.stopped = m_stopped;
+  summary.cutShort = summary.burnDetected && m_above;
+  summary.havePressure = m_havePressure;
+  summary.sequenceS = (m_endUs - m_startUs) / 1e6f;
+  summary.peakPressure = m_peakPressure;
+  if (summary.burnDetected) {
+    summary.burnTimeS = (m_lastAboveUs - m_ignitionUs) / 1e6f;
+    summary.peakThrust = m_peakThrust;
+    summary.peakThrustTimeS = (m_peakThrustUs - m_ignitionUs) / 1e6f;
+    summary.totalImpulse = m_impulseAtLastAbove;
+    summary.averageThrust = (summary.burnTimeS > 0.0f) ? summary.totalImpulse / summary.burnTimeS : m_peakThrust;
+  }
+
+  portENTER_CRITICAL(&m_mux);
+  m_summary = summary;
+  m_summaryReady = true;
+  portEXIT_CRITICAL(&m_mux);
+
+  m_state = State::IDLE;
+  m_ending = false;
+}
+
+bool BurnMonitor::takeSummary(Summary &summary) {
+  portENTER_CRITICAL(&m_mux);
+  bool ready = m_summaryReady;
+  if (ready) summary = m_summary;
+  m_summaryReady = false;
+  portEXIT_CRITICAL(&m_mux);
+  return ready;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <atomic>
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+
+// Burn summary worked out while a sequence runs, so peak thrust, burn time and total impulse are
+// known the moment it ends instead of after the SD card is pulled. The burn starts when thrust first
+// rises above the threshold and ends the last time it is seen above it, so a motor that chuffs or
+// tails off slowly is still measured once. Impulse is the trapezoid integral of every thrust sample
+// from ignition, taken at the last sample above the threshold. O(1) per sample.
+// The sequencer starts and ends tracking from its own task (or the E-stop ISR), the analog task
+// feeds it, and the summary is handed to whoever sends it.
+class BurnMonitor {
+ public:
+  // A burn still going when the sequence ends is followed for at most this long
+  static constexpr uint64_t END_GRACE_US = 1'000'000;
+
+  struct Summary {
+    bool burnDetected;  // thrust crossed the threshold during the sequence
+    bool stopped;       // ended by a stop or E-stop rather than running to completion
+    bool cutShort;      // still above the threshold when tracking ended
+    bool havePressure;
+    float sequenceS;  // sequence start to end
+    float burnTimeS;
+    float peakThrust;
+    float peakThrustTimeS;  // after ignition
+    float totalImpulse;     // thrust units x s
+    float averageThrust;    // over the burn time
+    float peakPressure;     // over the whole sequence
+  };
+
+  // Analog task: thrust above `threshold`, in the thrust channel's units, counts as burning
+  void setThreshold(float threshold) { m_threshold = threshold; }
+
+  // Any task or ISR. Picked up by the analog task at its next sample
+  void start() { m_requests.fetch_or(REQUEST_START, std::memory_order_release); }
+  void end(bool stopped) { m_requests.fetch_or(stopped ? (REQUEST_END | REQUEST_STOPPED) : REQUEST_END, std::memory_order_release); }
+
+  // Analog task, every sample. `haveThrust` / `havePressure` say whether the values are fresh
+  void feed(uint64_t timestampUs, bool haveThrust, float thrust, bool havePressure, float pressure);
+
+  // Analog task: a sequence is being followed, from its start until its summary is made
+  bool tracking() const { return m_state != State::IDLE; }
+
+  // Any task: the summary of the last sequence, once
+  bool takeSummary(Summary &summary);
+
+ private:
+  static constexpr uint8_t REQUEST_START = 1 << 0;
+  static constexpr uint8_t REQUEST_END = 1 << 1;
+  static constexpr uint8_t REQUEST_STOPPED = 1 << 2;
+
+  enum class State : uint8_t { IDLE, ARMED, BURNING };
+
+  void finish();
+
+  std::atomic<uint8_t> m_requests{0};
+  float m_threshold = 0.0f;
+
+  // Analog task only
+  State m_state = State::IDLE;
+  bool m_ending = false;
+  bool m_stopped = false;
+  uint64_t m_startUs = 0;
+  uint64_t m_endUs = 0;
+  uint64_t m_ignitionUs = 0;
+  uint64_t m_lastAboveUs = 0;
+  uint64_t m_lastThrustUs = 0;
+  float m_lastThrust = 0.0f;
+  bool m_above = false;
+  float m_impulse = 0.0f;
+  float m_impulseAtLastAbove = 0.0f;
+  float m_peakThrust = 0.0f;
+  uint64_t m_peakThrustUs = 0;
+  bool m_havePressure = false;
+  float m_peakPressure = 0.0f;
+
+  portMUX_TYPE m_mux = portMUX_INITIALIZER_UNLOCKED;
+  Summary m_summary = {};
+  bool m_summaryReady = false;
+
+  static constexpr const char *TAG = "BurnMonitor";
+};
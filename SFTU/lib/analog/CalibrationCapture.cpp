@@ -0,0 +1,74 @@
+#include "CalibrationCapture.hpp"
+
+bool CalibrationCapture::start(int channel, CaptureMode mode, float units, uint32_t samples) {
+  if (channel < 0 || channel >= (int)NUM_CHANNELS || mode == CaptureMode::NONE || samples == 0) return false;
+  if (!m_processors[channel]) return false;
+
+  // Claim the channel in one step, so two commands racing for it can't both fill in the request.
+  // The analog task only looks at it once the mask bit is set below
+  Request &request = m_requests[channel];
+  CaptureMode idle = CaptureMode::NONE;
+  if (!request.mode.compare_exchange_strong(idle, mode, std::memory_order_acq_rel)) return false;
+  if (mode == CaptureMode::POINT && m_numPoints[channel].load(std::memory_order_acquire) >= CalibrationCurve::MAX_POINTS) {
+    request.mode.store(CaptureMode::NONE, std::memory_order_release);
+    return false;
+  }
+
+  request.units = units;
+  request.target = samples;
+  request.count = 0;
+  request.sum = 0;
+  m_activeMask.fetch_or(1 << channel, std::memory_order_release);  // hands the request to the analog task
+  return true;
+}
+
+void CalibrationCapture::feed(const int32_t *counts, uint8_t mask) {
+  for (uint8_t active = m_activeMask.load(std::memory_order_acquire) & mask; active; active &= active - 1) {
+    int channel = __builtin_ctz(active);
+    Request &request = m_requests[channel];
+    request.sum += counts[channel];
+    if (++request.count >= request.target) finish(channel, request);
+  }
+}
+
+void CalibrationCapture::finish(int channel, Request &request) {
+  adcProcessor *processor = m_processors[channel];
+  float volts = (float)((double)request.sum / request.count) * m_lsbV[channel];
+
+  switch (request.mode.load(std::memory_order_relaxed)) {
+    case CaptureMode::POINT: {
+      // Stored against the tare at capture time, as the curve is evaluated on tared volts
+      float tared = volts - processor->getOffset();
+      uint8_t n = m_numPoints[channel].load(std::memory_order_relaxed);
+      m_points[channel][n] = {tared, request.units};
+      m_numPoints[channel].store(n + 1, std::memory_order_release);
+      ESP_LOGI(TAG, "CH%d point %u: %.6f V = %.3f units over %u samples", channel + 1, n + 1, tared, request.units, request.count);
+      break;
+    }
+    case CaptureMode::TARE:
+      processor->tareVolts(volts);
+      ESP_LOGI(TAG, "CH%d tared at %.6f V over %u samples", channel + 1, volts, request.count);
+      break;
+    case CaptureMode::CALIBRATE:
+      processor->calibrate(request.units, volts);
+      break;
+    default:
+      break;
+  }
+
+  m_activeMask.fetch_and(~(1 << channel), std::memory_order_release);
+  request.mode.store(CaptureMode::NONE, std::memory_order_release);
+}
+
+size_t CalibrationCapture::getPoints(int channel, CalibrationPoint *points) const {
+  if (channel < 0 || channel >= (int)NUM_CHANNELS) return 0;
+  size_t n = m_numPoints[channel].load(std::memory_order_acquire);
+  for (size_t i = 0; i < n; ++i) points[i] = m_points[channel][i];
+  return n;
+}
+
+bool CalibrationCapture::clear(int channel) {
+  if (channel < 0 || channel >= (int)NUM_CHANNELS || busy(channel)) return false;
+  m_numPoints[channel].store(0, std::memory_order_release);
+  return true;
+}
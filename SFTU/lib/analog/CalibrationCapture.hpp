@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <atomic>
+
+#include "CalibrationCurve.hpp"
+#include "adcProcessor.hpp"
+
+// What to do with the average once a capture finishes
+enum class CaptureMode : uint8_t {
+  NONE = 0,
+  POINT = 1,      // store a multi-point calibration point at the given units
+  TARE = 2,       // zero the channel at its current level
+  CALIBRATE = 3,  // single-point linear scale from the current level to the given units
+};
+
+// Averages of a channel's samples taken from the running stream for tare and calibration. A
+// command asks for one on a channel; the analog task averages that channel's next samples and
+// applies the result, so acquisition never stops and other channels keep logging. Each channel
+// can have one capture running, several channels can run at once. Multi-point calibration points
+// are kept per channel until cleared and compiled with adcProcessor::setCurve.
+class CalibrationCapture {
+ public:
+  static constexpr size_t NUM_CHANNELS = 8;
+
+  // `lsbV` is volts per stored count for each channel, as given to ChannelConverter
+  CalibrationCapture(adcProcessor *const *processors, const float *lsbV) : m_processors(processors), m_lsbV(lsbV) {}
+
+  // Any task: average the next `samples` samples of `channel` (0-7), `units` is the applied load for
+  // POINT and CALIBRATE. False if that channel is already capturing or has no room for another point
+  bool start(int channel, CaptureMode mode, float units, uint32_t samples);
+  bool busy(int channel) const { return m_requests[channel].mode.load(std::memory_order_acquire) != CaptureMode::NONE; }
+
+  // Analog task: every sample, cheap when no capture is running
+  void feed(const int32_t *counts, uint8_t mask);
+
+  // Copy out the points captured so far for `channel`, returns how many
+  size_t getPoints(int channel, CalibrationPoint *points) const;
+  // False while that channel is being captured
+  bool clear(int channel);
+
+ private:
+  struct Request {
+    std::atomic<CaptureMode> mode{CaptureMode::NONE};
+    float units = 0.0f;
+    uint32_t target = 0;
+    uint32_t count = 0;
+    int64_t sum = 0;
+  };
+
+  void finish(int channel, Request &request);
+
+  adcProcessor *const *m_processors;
+  const float *m_lsbV;
+
+  Request m_requests[NUM_CHANNELS];
+  std::atomic<uint8_t> m_activeMask{0};  // channels with a capture running, saves the analog task a scan
+
+  CalibrationPoint m_points[NUM_CHANNELS][CalibrationCurve::MAX_POINTS];
+  std::atomic<uint8_t> m_numPoints[NUM_CHANNELS] = {};
+
+  static constexpr const char *TAG = "CalibrationCapture";
+};
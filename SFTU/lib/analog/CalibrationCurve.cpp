@@ -0,0 +1,54 @@
+#include "CalibrationCurve.hpp"
+
+#include <algorithm>
+
+bool CalibrationCurve::compileTable(const CalibrationPoint *points, size_t count) {
+  if (count < 2 || count > MAX_POINTS) {
+    ESP_LOGW(TAG, "Need 2 to %u points, got %u", (unsigned)MAX_POINTS, (unsigned)count);
+    return false;
+  }
+
+  CalibrationPoint sorted[MAX_POINTS];
+  std::copy(points, points + count, sorted);
+  std::sort(sorted, sorted + count, [](const CalibrationPoint &a, const CalibrationPoint &b) { return a.volts < b.volts; });
+  for (size_t i = 1; i < count; ++i) {
+    if (sorted[i].volts - sorted[i - 1].volts <= 0.0f) {
+      ESP_LOGW(TAG, "Two points at %.6f V", sorted[i].volts);
+      return false;
+    }
+  }
+
+  float x0 = sorted[0].volts;
+  float step = (sorted[count - 1].volts - x0) / (TABLE_SIZE - 1);
+  size_t segment = 0;
+  for (size_t i = 0; i < TABLE_SIZE; ++i) {
+    float x = x0 + i * step;
+    while (segment < count - 2 && x > sorted[segment + 1].volts) segment++;
+    const CalibrationPoint &a = sorted[segment];
+    const CalibrationPoint &b = sorted[segment + 1];
+    m_values[i] = a.units + (x - a.volts) * (b.units - a.units) / (b.volts - a.volts);
+  }
+
+  m_x0 = x0;
+  m_invStep = 1.0f / step;
+  m_terms = 0;
+  m_kind = Kind::TABLE;
+
+  // The grid only passes through the points exactly when they land on it, report how far off it is
+  float worst = 0.0f;
+  for (size_t i = 0; i < count; ++i) worst = std::max(worst, fabsf(evaluate(sorted[i].volts) - sorted[i].units));
+  ESP_LOGI(TAG, "Table from %u points over %.6f to %.6f V, worst point error %.4f units", (unsigned)count, x0, sorted[count - 1].volts, worst);
+  return true;
+}
+
+bool CalibrationCurve::compilePolynomial(const float *coeffs, size_t count) {
+  if (count == 0 || count > MAX_TERMS) {
+    ESP_LOGW(TAG, "Need 1 to %u coefficients, got %u", (unsigned)MAX_TERMS, (unsigned)count);
+    return false;
+  }
+  std::copy(coeffs, coeffs + count, m_values);
+  m_terms = count;
+  m_kind = Kind::POLYNOMIAL;
+  ESP_LOGI(TAG, "Polynomial of order %u", (unsigned)count - 1);
+  return true;
+}
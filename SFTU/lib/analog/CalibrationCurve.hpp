@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Arduino.h>
+
+// One measured point of a multi-point calibration, volts after the tare offset
+struct CalibrationPoint {
+  float volts;
+  float units;
+};
+
+// Non-linear tared-volts to units mapping, compiled once so evaluating it per sample costs little
+// more than the linear scale. A set of points is resampled onto a uniform grid, so lookup is a
+// multiply to find the cell and a multiply-add to interpolate, with the end cells extrapolated
+// beyond the calibrated range. A polynomial is evaluated with Horner's rule.
+// A plain copyable value so each ChannelConverter can hold its own.
+class CalibrationCurve {
+ public:
+  enum class Kind : uint8_t { LINEAR = 0, TABLE = 1, POLYNOMIAL = 2 };
+
+  static constexpr size_t TABLE_SIZE = 33;  // 32 cells over the calibrated range
+  static constexpr size_t MAX_POINTS = 16;
+  static constexpr size_t MAX_TERMS = 6;  // up to 5th order
+
+  // Piecewise linear through at least 2 points with distinct volts, in any order
+  bool compileTable(const CalibrationPoint *points, size_t count);
+  // units = coeffs[0] + coeffs[1] * v + coeffs[2] * v^2 ...
+  bool compilePolynomial(const float *coeffs, size_t count);
+  // Back to LINEAR, the owner's scale factor applies again
+  void clear() { m_kind = Kind::LINEAR; }
+
+  Kind kind() const { return m_kind; }
+  bool active() const { return m_kind != Kind::LINEAR; }
+
+  float evaluate(float volts) const {
+    if (m_kind == Kind::TABLE) {
+      float pos = (volts - m_x0) * m_invStep;
+      int cell = (int)floorf(pos);
+      cell = std::min(std::max(cell, 0), (int)TABLE_SIZE - 2);
+      float frac = pos - cell;
+      return m_values[cell] + frac * (m_values[cell + 1] - m_values[cell]);
+    }
+    float units = 0.0f;
+    for (int i = (int)m_terms - 1; i >= 0; --i) units = units * volts + m_values[i];
+    return units;
+  }
+
+ private:
+  Kind m_kind = Kind::LINEAR;
+  uint8_t m_terms = 0;
+  float m_x0 = 0.0f;
+  float m_invStep = 0.0f;
+  float m_values[TABLE_SIZE] = {0};  // table entries, or polynomial coefficients lowest order first
+
+  static constexpr const char *TAG = "CalibrationCurve";
+};
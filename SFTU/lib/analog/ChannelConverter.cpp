@@ -0,0 +1,85 @@
+#include "ChannelConverter.hpp"
+
+void ChannelConverter::reload() {
+  // Retried like a SeqLock read if an update overlapped the copy. Writers hold a spinlock for the
+  // few stores of an update, so this spins for microseconds at most
+  while (true) {
+    uint32_t generation = adcProcessor::generation();
+    if (generation & 1) continue;
+    m_curveMask = 0;
+    for (size_t i = 0; i < NUM_CHANNELS; ++i) {
+      float scale = m_processors[i] ? m_processors[i]->getScale() : 0.0f;
+      float offset = m_processors[i] ? m_processors[i]->getOffset() : 0.0f;
+      if (m_processors[i] && m_processors[i]->getCurve().active()) {
+        // The linear pass stops at tared volts, the curve does the rest
+        m_curves[i] = m_processors[i]->getCurve();
+        m_curveMask |= (1 << i);
+        scale = 1.0f;
+      }
+      // (counts * lsb - offset) * scale
+      m_unitsPerCount[i] = m_lsbV[i] * scale;
+      m_unitsOffset[i] = offset * scale;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (adcProcessor::generation() == generation) {
+      m_generation = generation;
+      return;
+    }
+  }
+}
+
+void ChannelConverter::convert(const int32_t *counts, float *units, uint8_t mask) {
+  refresh();
+  for (size_t i = 0; i < NUM_CHANNELS; ++i) {
+    float keep = (float)((mask >> i) & 1);
+    units[i] = (counts[i] * m_unitsPerCount[i] - m_unitsOffset[i]) * keep;
+  }
+  for (uint8_t curves = m_curveMask & mask; curves; curves &= curves - 1) {
+    size_t i = __builtin_ctz(curves);
+    units[i] = m_curves[i].evaluate(units[i]);
+  }
+}
+
+float ChannelConverter::toUnits(size_t idx, int32_t counts) {
+  refresh();
+  float units = counts * m_unitsPerCount[idx] - m_unitsOffset[idx];
+  return (m_curveMask & (1 << idx)) ? m_curves[idx].evaluate(units) : units;
+}
+
+void ChannelConverter::describe(SampleLayout &layout) {
+  refresh();
+  for (int slot = 0; slot < layout.numChannels; ++slot) {
+    layout.unitsPerCount[slot] = m_unitsPerCount[layout.channel[slot]];
+    layout.unitsOffset[slot] = m_unitsOffset[layout.channel[slot]];
+    layout.curve[slot] = (m_curveMask & (1 << layout.channel[slot])) ? &m_curves[layout.channel[slot]] : nullptr;
+  }
+}
+
+void ChannelConverter::benchmark(uint32_t iterations) {
+  if (iterations == 0) return;
+
+  int32_t counts[NUM_CHANNELS];
+  float units[NUM_CHANNELS];
+  for (size_t i = 0; i < NUM_CHANNELS; ++i) counts[i] = 1000 * (i + 1);
+  volatile float sink = 0.0f;  // keeps the loops from being optimised away
+
+  uint32_t start = ESP.getCycleCount();
+  for (uint32_t n = 0; n < iterations; ++n) {
+    for (size_t i = 0; i < NUM_CHANNELS; ++i) {
+      // Unfiltered, convert() doesn't filter either and filter cost would swamp the comparison
+      if (m_processors[i]) units[i] = m_processors[i]->voltsToUnits(counts[i] * m_lsbV[i]);
+    }
+    sink = sink + units[n % NUM_CHANNELS];
+  }
+  uint32_t perCallCycles = ESP.getCycleCount() - start;
+
+  start = ESP.getCycleCount();
+  for (uint32_t n = 0; n < iterations; ++n) {
+    convert(counts, units, 0xFF);
+    sink = sink + units[n % NUM_CHANNELS];
+  }
+  uint32_t blockCycles = ESP.getCycleCount() - start;
+
+  float samples = (float)iterations * NUM_CHANNELS;
+  ESP_LOGI(TAG, "Conversion cycles/sample: per-call %.1f, block %.1f", perCallCycles / samples, blockCycles / samples);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "SD_Talker.hpp"
+#include "adcProcessor.hpp"
+
+// Raw ADS1115 counts to engineering units, for the places that actually need units (display,
+// telemetry, SD export) rather than the acquisition task. Each channel folds its LSB size, tare
+// offset and scale into one multiply and one subtract, held in contiguous arrays so a whole scan
+// converts in a single branch-free pass. Channels with a multi-point or polynomial calibration take
+// the same pass to tared volts and then go through their curve. adcProcessor stays the owner of the
+// calibration; the arrays are refreshed whenever any processor's offset, scale or curve changes.
+// Not shared between tasks, each consumer keeps its own.
+class ChannelConverter {
+ public:
+  static constexpr size_t NUM_CHANNELS = 8;
+
+  // `lsbV` is volts per stored count for each channel (the ADC LSB over any oversampling factor), owned by the caller
+  ChannelConverter(adcProcessor *const *processors, const float *lsbV) : m_processors(processors), m_lsbV(lsbV) {}
+
+  // Convert channels whose bit is set in `mask`, the rest come out as 0. Filters are not applied
+  void convert(const int32_t *counts, float *units, uint8_t mask);
+  float toUnits(size_t idx, int32_t counts);
+
+  // Fill in the per-slot conversion of a packed record layout
+  void describe(SampleLayout &layout);
+
+  // Time the per-channel adcProcessor conversion against convert() over `iterations` scans and log
+  // cycles per sample. Neither runs the filters, so only the conversion itself is compared
+  void benchmark(uint32_t iterations);
+
+ private:
+  void refresh() {
+    if (m_generation != adcProcessor::generation()) reload();
+  }
+  void reload();
+
+  adcProcessor *const *m_processors;
+  const float *m_lsbV;
+  uint32_t m_generation = UINT32_MAX;
+
+  alignas(16) float m_unitsPerCount[NUM_CHANNELS] = {0};
+  alignas(16) float m_unitsOffset[NUM_CHANNELS] = {0};
+  uint8_t m_curveMask = 0;  // channels evaluated through m_curves
+  CalibrationCurve m_curves[NUM_CHANNELS];
+
+  static constexpr const char *TAG = "ChannelConverter";
+};
@@ -0,0 +1,238 @@
+#include "DerivedChannels.hpp"
+
+#include <ctype.h>
+
+static void skipSpaces(const char *&p) {
+  while (isspace((unsigned char)*p)) p++;
+}
+
+// True and past `word` if the text continues with it as a whole identifier
+static bool matchWord(const char *&p, const char *word) {
+  size_t len = strlen(word);
+  if (strncasecmp(p, word, len) != 0 || isalnum((unsigned char)p[len])) return false;
+  p += len;
+  return true;
+}
+
+bool DerivedChannels::add(const char *expression) {
+  if (m_numChannels >= MAX_CHANNELS) {
+    ESP_LOGW(TAG, "Only %u derived channels, ignoring '%s'", (unsigned)MAX_CHANNELS, expression);
+    return false;
+  }
+
+  // Roll back to here if the expression doesn't compile
+  size_t programSize = m_programSize;
+  size_t numStates = m_numStates;
+  uint8_t inputMask = m_inputMask;
+
+  Parser parser = {expression, true, 0};
+  bool ok = parseExpression(parser);
+  skipSpaces(parser.p);
+  if (ok && *parser.p != '\0') ok = false;
+  if (ok) ok = emit(Op::STORE, m_numChannels);
+
+  // Every operator leaves one value in place of its operands, so walk the new code for the peak depth
+  size_t depth = 0, maxDepth = 0;
+  for (size_t i = programSize; ok && i < m_programSize; ++i) {
+    switch (m_program[i].op) {
+      case Op::CHANNEL:
+      case Op::DERIVED:
+      case Op::CONSTANT:
+        depth++;
+        break;
+      case Op::ADD:
+      case Op::SUB:
+      case Op::MUL:
+      case Op::DIV:
+      case Op::STORE:
+        depth--;
+        break;
+      default:
+        break;
+    }
+    maxDepth = std::max(maxDepth, depth);
+  }
+  if (ok && maxDepth > MAX_STACK) ok = false;
+
+  if (!ok) {
+    ESP_LOGE(TAG, "D%u: can't compile '%s' near '%s'", (unsigned)m_numChannels + 1, expression, parser.p);
+    m_programSize = programSize;
+    m_numStates = numStates;
+    m_inputMask = inputMask;
+    return false;
+  }
+
+  m_numChannels++;
+  ESP_LOGI(TAG, "D%u = %s (%u instructions)", (unsigned)m_numChannels, expression, (unsigned)(m_programSize - programSize));
+  return true;
+}
+
+void DerivedChannels::clear() {
+  // The next program reuses the slots from the first one, so it mustn't inherit their totals
+  for (State &s : m_state) s = State{0.0f, 0.0f, false};
+  m_programSize = 0;
+  m_numChannels = 0;
+  m_numStates = 0;
+  m_inputMask = 0;
+  resetStats();
+}
+
+bool DerivedChannels::emit(Op op, uint8_t arg, float value) {
+  if (m_programSize >= MAX_PROGRAM) return false;
+  m_program[m_programSize++] = {op, arg, value};
+  return true;
+}
+
+bool DerivedChannels::parseExpression(Parser &parser) {
+  if (!parseTerm(parser)) return false;
+  while (true) {
+    skipSpaces(parser.p);
+    char c = *parser.p;
+    if (c != '+' && c != '-') return true;
+    parser.p++;
+    if (!parseTerm(parser) || !emit(c == '+' ? Op::ADD : Op::SUB)) return false;
+  }
+}
+
+bool DerivedChannels::parseTerm(Parser &parser) {
+  if (!parseUnary(parser)) return false;
+  while (true) {
+    skipSpaces(parser.p);
+    char c = *parser.p;
+    if (c != '*' && c != '/') return true;
+    parser.p++;
+    if (!parseUnary(parser) || !emit(c == '*' ? Op::MUL : Op::DIV)) return false;
+  }
+}
+
+bool DerivedChannels::parseUnary(Parser &parser) {
+  // Every recursion comes back through here, so a long run of '(' or '-' in the config can't
+  // overflow the task's stack
+  if (parser.depth >= MAX_NESTING) return false;
+  parser.depth++;
+  skipSpaces(parser.p);
+  bool ok;
+  if (*parser.p == '-') {
+    parser.p++;
+    ok = parseUnary(parser) && emit(Op::NEG);
+  } else {
+    ok = parsePrimary(parser);
+  }
+  parser.depth--;
+  return ok;
+}
+
+bool DerivedChannels::parsePrimary(Parser &parser) {
+  skipSpaces(parser.p);
+  const char *&p = parser.p;
+
+  if (*p == '(') {
+    p++;
+    if (!parseExpression(parser)) return false;
+    skipSpaces(p);
+    if (*p != ')') return false;
+    p++;
+    return true;
+  }
+
+  if (isdigit((unsigned char)*p) || *p == '.') {
+    char *end;
+    float value = strtof(p, &end);
+    if (end == p) return false;
+    p = end;
+    return emit(Op::CONSTANT, 0, value);
+  }
+
+  bool integral = matchWord(p, "integral");
+  if (integral || matchWord(p, "derivative")) {
+    skipSpaces(p);
+    if (*p != '(' || m_numStates >= MAX_STATE) return false;
+    uint8_t slot = m_numStates++;
+    return parsePrimary(parser) && emit(integral ? Op::INTEGRAL : Op::DERIVATIVE, slot);
+  }
+
+  // CHn is a physical channel 1-8, Dn an earlier derived channel
+  char kind = toupper((unsigned char)*p);
+  if (kind == 'C' && toupper((unsigned char)p[1]) == 'H') {
+    p += 2;
+    int n = strtol(p, const_cast<char **>(&p), 10);
+    if (n < 1 || n > 8) return false;
+    m_inputMask |= (1 << (n - 1));
+    return emit(Op::CHANNEL, n - 1);
+  }
+  if (kind == 'D') {
+    p++;
+    int n = strtol(p, const_cast<char **>(&p), 10);
+    if (n < 1 || n > (int)m_numChannels) return false;
+    return emit(Op::DERIVED, n - 1);
+  }
+  return false;
+}
+
+void DerivedChannels::evaluate(const float *units, float dtS, float *out) {
+  uint32_t start = ESP.getCycleCount();
+
+  float stack[MAX_STACK];
+  int top = -1;
+  for (size_t i = 0; i < m_programSize; ++i) {
+    const Instruction &in = m_program[i];
+    switch (in.op) {
+      case Op::CHANNEL:
+        stack[++top] = units[in.arg];
+        break;
+      case Op::DERIVED:
+        stack[++top] = out[in.arg];
+        break;
+      case Op::CONSTANT:
+        stack[++top] = in.value;
+        break;
+      case Op::ADD:
+        top--;
+        stack[top] += stack[top + 1];
+        break;
+      case Op::SUB:
+        top--;
+        stack[top] -= stack[top + 1];
+        break;
+      case Op::MUL:
+        top--;
+        stack[top] *= stack[top + 1];
+        break;
+      case Op::DIV:
+        top--;
+        stack[top] = (stack[top + 1] != 0.0f) ? stack[top] / stack[top + 1] : 0.0f;
+        break;
+      case Op::NEG:
+        stack[top] = -stack[top];
+        break;
+      case Op::INTEGRAL: {
+        // Trapezoidal, so a steady value integrates exactly whatever the tick rate
+        State &s = m_state[in.arg];
+        float x = stack[top];
+        if (s.primed) s.total += 0.5f * (x + s.previous) * dtS;
+        s.previous = x;
+        s.primed = true;
+        stack[top] = s.total;
+        break;
+      }
+      case Op::DERIVATIVE: {
+        State &s = m_state[in.arg];
+        float x = stack[top];
+        stack[top] = (s.primed && dtS > 0.0f) ? (x - s.previous) / dtS : 0.0f;
+        s.previous = x;
+        s.primed = true;
+        break;
+      }
+      case Op::STORE:
+        out[in.arg] = stack[top--];
+        break;
+    }
+  }
+
+  m_cycles += ESP.getCycleCount() - start;
+  m_evaluations++;
+}
+
+void DerivedChannels::reset() {
+  for (size_t i = 0; i < m_numStates; ++i) m_state[i] = State{0.0f, 0.0f, false};
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Channels computed from the physical ones each sample, e.g. total thrust or total impulse.
+// Each is an expression over CH1-CH8 (in units), earlier derived channels D1-D4 and numbers with
+// + - * / and brackets, plus integral(...) and derivative(...) over time. Expressions are compiled
+// once at setup into one flat stack program, so a sample costs a single pass over it.
+// Analog task only.
+class DerivedChannels {
+ public:
+  static constexpr size_t MAX_CHANNELS = 4;
+  static constexpr size_t MAX_PROGRAM = 64;
+  static constexpr size_t MAX_STACK = 8;
+  static constexpr size_t MAX_STATE = 8;  // integrals and derivatives across all channels
+  static constexpr size_t MAX_NESTING = 16;  // brackets and unary minuses, bounds the parser's recursion
+
+  // Compile `expression` as the next derived channel, D1 first. Logs and returns false on a bad one
+  bool add(const char *expression);
+  void clear();
+  size_t size() const { return m_numChannels; }
+  // Physical channels the program reads
+  uint8_t inputMask() const { return m_inputMask; }
+
+  // `units` holds the latest value of every physical channel, `dtS` the time since the last call.
+  // Writes size() values to `out`
+  void evaluate(const float *units, float dtS, float *out);
+  // Zero the integrals and forget the previous values the derivatives work from
+  void reset();
+
+  uint32_t evaluations() const { return m_evaluations; }
+  uint64_t cycles() const { return m_cycles; }
+  void resetStats() {
+    m_evaluations = 0;
+    m_cycles = 0;
+  }
+
+ private:
+  enum class Op : uint8_t { CHANNEL, DERIVED, CONSTANT, ADD, SUB, MUL, DIV, NEG, INTEGRAL, DERIVATIVE, STORE };
+
+  struct Instruction {
+    Op op;
+    uint8_t arg;  // channel, derived channel or state slot
+    float value;  // CONSTANT only
+  };
+
+  struct State {
+    float previous;
+    float total;
+    bool primed;
+  };
+
+  // Recursive descent over the expression text, emitting as it goes
+  struct Parser {
+    const char *p;
+    bool ok;
+    size_t depth;
+  };
+  bool parseExpression(Parser &parser);
+  bool parseTerm(Parser &parser);
+  bool parseUnary(Parser &parser);
+  bool parsePrimary(Parser &parser);
+  bool emit(Op op, uint8_t arg = 0, float value = 0.0f);
+
+  Instruction m_program[MAX_PROGRAM];
+  size_t m_programSize = 0;
+  size_t m_numChannels = 0;
+  uint8_t m_inputMask = 0;
+
+  State m_state[MAX_STATE] = {};
+  size_t m_numStates = 0;
+
+  uint32_t m_evaluations = 0;
+  uint64_t m_cycles = 0;
+
+  static constexpr const char *TAG = "DerivedChannels";
+};
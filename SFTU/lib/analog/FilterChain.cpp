@@ -0,0 +1,155 @@
+#include "FilterChain.hpp"
+
+bool FilterChain::addStage(FilterType type, float freqHz, float q, uint16_t length) {
+  if (m_numStages >= MAX_STAGES) {
+    ESP_LOGW(TAG, "Filter chain full, ignoring %s stage", typeName(type));
+    return false;
+  }
+
+  Stage &stage = m_stages[m_numStages];
+  stage.type = type;
+  stage.freqHz = freqHz;
+  stage.q = (q > 0.0f) ? q : 0.7071f;
+  if (type == FilterType::MOVING_AVERAGE) {
+    stage.average.length = std::min<uint16_t>(std::max<uint16_t>(length, 1), MAX_AVERAGE_LENGTH);
+    prime(stage.average, 0.0f);
+  } else {
+    stage.biquad.last = 0.0f;
+  }
+  design(stage);
+  if (type != FilterType::MOVING_AVERAGE) prime(stage.biquad, 0.0f);
+  m_primed = false;
+
+  m_stats[m_numStages] = FilterStageStats();
+  m_stats[m_numStages].type = type;
+  m_numStages++;
+  return true;
+}
+
+void FilterChain::clear() {
+  m_numStages = 0;
+  m_primed = false;
+}
+
+void FilterChain::setSampleRate(float sampleRateHz) {
+  // Schedules are rebuilt on every burst rate switch, usually without this channel's rate changing
+  if (sampleRateHz == m_sampleRateHz) return;
+  m_sampleRateHz = sampleRateHz;
+  for (size_t i = 0; i < m_numStages; ++i) {
+    Stage &stage = m_stages[i];
+    if (stage.type == FilterType::MOVING_AVERAGE) continue;
+    // Zeroed state would drop the output towards 0 and ring back, right when a burst is captured
+    design(stage);
+    prime(stage.biquad, stage.biquad.last);
+  }
+}
+
+void FilterChain::reset() { m_primed = false; }
+
+void FilterChain::design(Stage &stage) {
+  // The moving average is the same at any rate
+  if (stage.type == FilterType::MOVING_AVERAGE) return;
+
+  Biquad &bq = stage.biquad;
+
+  // Pass through until the rate is known, or if the corner is above Nyquist
+  if (m_sampleRateHz <= 0.0f || stage.freqHz <= 0.0f || stage.freqHz >= 0.5f * m_sampleRateHz) {
+    if (m_sampleRateHz > 0.0f) ESP_LOGW(TAG, "%s at %.1f Hz can't run at %.1f Hz, passing through", typeName(stage.type), stage.freqHz, m_sampleRateHz);
+    bq.b0 = 1.0f;
+    bq.b1 = bq.b2 = bq.a1 = bq.a2 = 0.0f;
+    return;
+  }
+
+  float w0 = 2.0f * PI * stage.freqHz / m_sampleRateHz;
+  float cosw0 = cosf(w0);
+  float alpha = sinf(w0) / (2.0f * stage.q);
+  float a0 = 1.0f + alpha;
+
+  if (stage.type == FilterType::NOTCH) {
+    bq.b0 = 1.0f / a0;
+    bq.b1 = -2.0f * cosw0 / a0;
+    bq.b2 = 1.0f / a0;
+  } else {
+    bq.b0 = (1.0f - cosw0) / 2.0f / a0;
+    bq.b1 = (1.0f - cosw0) / a0;
+    bq.b2 = bq.b0;
+  }
+  bq.a1 = -2.0f * cosw0 / a0;
+  bq.a2 = (1.0f - alpha) / a0;
+}
+
+void FilterChain::prime(Biquad &bq, float level) {
+  // Steady state for a constant input at `level`. Both designs have unity DC gain, so the output is there too
+  bq.z2 = bq.b2 * level - bq.a2 * level;
+  bq.z1 = bq.b1 * level - bq.a1 * level + bq.z2;
+  bq.last = level;
+}
+
+void FilterChain::prime(MovingAverage &avg, float level) {
+  avg.index = 0;
+  for (uint16_t i = 0; i < avg.length; ++i) avg.window[i] = level;
+  avg.sum = level * avg.length;
+}
+
+float FilterChain::runBiquad(Biquad &bq, float x) {
+  float y = bq.b0 * x + bq.z1;
+  bq.z1 = bq.b1 * x - bq.a1 * y + bq.z2;
+  bq.z2 = bq.b2 * x - bq.a2 * y;
+  bq.last = y;
+  return y;
+}
+
+float FilterChain::runAverage(MovingAverage &avg, float x) {
+  avg.sum += x - avg.window[avg.index];
+  avg.window[avg.index] = x;
+  if (++avg.index >= avg.length) {
+    avg.index = 0;
+    // Rebuild the sum once per window so rounding error doesn't drift
+    float sum = 0.0f;
+    for (uint16_t i = 0; i < avg.length; ++i) sum += avg.window[i];
+    avg.sum = sum;
+  }
+  return avg.sum / avg.length;
+}
+
+float FilterChain::process(float x) {
+  if (!m_primed) {
+    // Every stage has unity DC gain, so settled on a constant input each one sits at that input
+    for (size_t i = 0; i < m_numStages; ++i) {
+      Stage &stage = m_stages[i];
+      if (stage.type == FilterType::MOVING_AVERAGE) {
+        prime(stage.average, x);
+      } else {
+        prime(stage.biquad, x);
+      }
+    }
+    m_primed = true;
+  }
+  for (size_t i = 0; i < m_numStages; ++i) {
+    uint32_t start = ESP.getCycleCount();
+    Stage &stage = m_stages[i];
+    x = (stage.type == FilterType::MOVING_AVERAGE) ? runAverage(stage.average, x) : runBiquad(stage.biquad, x);
+    m_stats[i].cycles += ESP.getCycleCount() - start;
+    m_stats[i].count++;
+  }
+  return x;
+}
+
+void FilterChain::resetStats() {
+  for (size_t i = 0; i < m_numStages; ++i) {
+    m_stats[i].count = 0;
+    m_stats[i].cycles = 0;
+  }
+}
+
+const char *FilterChain::typeName(FilterType type) {
+  switch (type) {
+    case FilterType::NOTCH:
+      return "notch";
+    case FilterType::LOWPASS:
+      return "lowpass";
+    case FilterType::MOVING_AVERAGE:
+      return "moving_average";
+  }
+  return "unknown";
+}
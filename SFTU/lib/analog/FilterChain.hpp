@@ -0,0 +1,80 @@
+#pragma once
+
+#include <Arduino.h>
+
+enum class FilterType : uint8_t { NOTCH = 0, LOWPASS = 1, MOVING_AVERAGE = 2 };
+
+// Cost of one stage since the last reset, in CPU cycles
+struct FilterStageStats {
+  FilterType type;
+  uint32_t count = 0;
+  uint64_t cycles = 0;
+};
+
+// Streaming per-channel filter chain. Samples go through one at a time as each conversion lands,
+// so the display, telemetry and triggers see filtered values with no block latency.
+// Biquads are transposed direct form II with coefficients from the RBJ cookbook; the moving average
+// keeps a running sum that is rebuilt once per window so float error can't accumulate. A new or
+// reset chain takes its state from the first sample, as if it had been settled there, so it
+// doesn't ramp up from zero.
+class FilterChain {
+ public:
+  static constexpr size_t MAX_STAGES = 4;
+  static constexpr size_t MAX_AVERAGE_LENGTH = 64;
+
+  // `freqHz` and `q` are used by the biquads, `length` by the moving average
+  bool addStage(FilterType type, float freqHz, float q, uint16_t length);
+  void clear();
+
+  // Redesign the biquads for a new sample rate, a no-op if it hasn't changed. Filter state carries
+  // on: a redesigned biquad restarts from its last output as if it had settled there
+  void setSampleRate(float sampleRateHz);
+  // Start over from the next sample
+  void reset();
+
+  float process(float x);
+
+  size_t numStages() const { return m_numStages; }
+  FilterStageStats getStageStats(size_t stage) const { return m_stats[stage]; }
+  void resetStats();
+
+  static const char *typeName(FilterType type);
+
+ private:
+  struct Biquad {
+    float b0, b1, b2, a1, a2;  // normalised so a0 = 1
+    float z1, z2;
+    float last;  // previous output, the level a redesign primes the state to
+  };
+
+  struct MovingAverage {
+    uint16_t length;
+    uint16_t index;
+    float sum;
+    float window[MAX_AVERAGE_LENGTH];
+  };
+
+  struct Stage {
+    FilterType type;
+    float freqHz;
+    float q;
+    union {
+      Biquad biquad;
+      MovingAverage average;
+    };
+  };
+
+  void design(Stage &stage);
+  static void prime(Biquad &bq, float level);
+  static void prime(MovingAverage &avg, float level);
+  static float runBiquad(Biquad &bq, float x);
+  static float runAverage(MovingAverage &avg, float x);
+
+  Stage m_stages[MAX_STAGES];
+  FilterStageStats m_stats[MAX_STAGES];
+  size_t m_numStages = 0;
+  float m_sampleRateHz = 0.0f;
+  bool m_primed = false;  // false until the first sample after a stage was added or a reset
+
+  static constexpr const char *TAG = "FilterChain";
+};
@@ -0,0 +1,32 @@
+#include "QuietDetector.hpp"
+
+void QuietDetector::configure(const Band bands[NUM_CHANNELS], uint64_t holdUs) {
+  m_bandMask = 0;
+  for (size_t i = 0; i < NUM_CHANNELS; ++i) {
+    m_band[i] = bands[i];
+    if (bands[i].enabled) m_bandMask |= (1 << i);
+  }
+  m_holdUs = holdUs;
+  m_haveLast = 0;
+  m_fresh = true;
+}
+
+bool QuietDetector::quiet(uint64_t timestampUs, const float *units, uint8_t mask, bool busy) {
+  bool excursion = busy || m_fresh || !m_bandMask;
+  m_fresh = false;
+
+  for (uint8_t active = mask; active; active &= active - 1) {
+    size_t i = __builtin_ctz(active);
+    const Band &band = m_band[i];
+    if (!band.enabled) continue;
+    float x = units[i];
+    if (x < band.min || x > band.max) excursion = true;
+    if ((m_haveLast & (1 << i)) && timestampUs > m_lastUs[i] && fabsf(x - m_last[i]) * 1e6f > band.rate * (float)(timestampUs - m_lastUs[i])) excursion = true;
+    m_last[i] = x;
+    m_lastUs[i] = timestampUs;
+    m_haveLast |= (1 << i);
+  }
+
+  if (excursion) m_fullRateUntilUs = timestampUs + m_holdUs;
+  return !excursion && timestampUs >= m_fullRateUntilUs;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <cmath>
+
+// Decides, sample by sample, whether the rig is quiet enough to log at a low rate: every channel
+// with a band is inside its level limits and changing no faster than its rate limit. Any excursion,
+// or the caller saying it's busy, means full rate until the hold time has passed without another.
+// O(1) per channel per sample, analog task only.
+class QuietDetector {
+ public:
+  static constexpr size_t NUM_CHANNELS = 8;
+
+  // In the channel's units and units/s. Channels without a band are ignored
+  struct Band {
+    bool enabled = false;
+    float min = -INFINITY;
+    float max = INFINITY;
+    float rate = INFINITY;
+  };
+
+  // New bands and hold time. Starts out at full rate for a hold time, rates restart from the next sample
+  void configure(const Band bands[NUM_CHANNELS], uint64_t holdUs);
+  // Without any band there is nothing to call quiet, and quiet() always says full rate
+  bool hasBands() const { return m_bandMask != 0; }
+
+  // Every sample: `units` for the channels in `mask`, `busy` forces the full rate (e.g. a sequence is running)
+  bool quiet(uint64_t timestampUs, const float *units, uint8_t mask, bool busy);
+
+ private:
+  Band m_band[NUM_CHANNELS];
+  uint8_t m_bandMask = 0;  // channels with a band enabled
+  uint64_t m_holdUs = 0;
+
+  float m_last[NUM_CHANNELS] = {0};
+  uint64_t m_lastUs[NUM_CHANNELS] = {0};
+  uint8_t m_haveLast = 0;  // bit n set once channel n has a previous value to take the rate from
+
+  bool m_fresh = true;
+  uint64_t m_fullRateUntilUs = 0;
+};
@@ -0,0 +1,166 @@
+#include "SpectrumAnalyzer.hpp"
+
+#include <algorithm>
+
+#include "esp_heap_caps.h"
+
+SpectrumAnalyzer::~SpectrumAnalyzer() {
+  if (m_taskHandle) vTaskDelete(m_taskHandle);
+  heap_caps_free(m_buffer);
+}
+
+bool SpectrumAnalyzer::begin() {
+  size_t bytes = 2 * MAX_LENGTH * sizeof(float);
+  m_buffer = static_cast<float *>(heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+  if (m_buffer == nullptr) m_buffer = static_cast<float *>(heap_caps_malloc(bytes, MALLOC_CAP_8BIT));
+  if (m_buffer == nullptr) {
+    ESP_LOGE(TAG, "Failed to allocate %u bytes for the FFT", (unsigned)bytes);
+    return false;
+  }
+
+  // Below the analog and SD tasks, so an analysis only ever uses spare time
+  xTaskCreate([](void *param) { static_cast<SpectrumAnalyzer *>(param)->taskLoop(); }, "SpectrumTask", 6144, this, 1, &m_taskHandle);
+  return true;
+}
+
+bool SpectrumAnalyzer::start(int channel, size_t length) {
+  if (m_buffer == nullptr || channel < 0 || channel >= 8 || busy()) return false;
+  if (length < 64 || length > MAX_LENGTH || (length & (length - 1)) != 0) return false;
+
+  m_channel = channel;
+  m_length = length;
+  m_count = 0;
+  m_state.store(State::CAPTURING, std::memory_order_release);  // hands the buffer to the analog task
+  return true;
+}
+
+void SpectrumAnalyzer::feed(uint64_t timestampUs, const int32_t *counts, uint8_t mask) {
+  if (m_state.load(std::memory_order_acquire) != State::CAPTURING || !(mask & (1 << m_channel))) return;
+
+  if (m_count == 0) m_firstUs = timestampUs;
+  m_lastUs = timestampUs;
+  m_buffer[2 * m_count] = (float)counts[m_channel];
+  m_buffer[2 * m_count + 1] = 0.0f;
+  if (++m_count < m_length) return;
+
+  m_state.store(State::ANALYSING, std::memory_order_release);
+  xTaskNotifyGive(m_taskHandle);
+}
+
+void SpectrumAnalyzer::taskLoop() {
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (m_state.load(std::memory_order_acquire) != State::ANALYSING) continue;
+    analyse();
+    m_state.store(State::IDLE, std::memory_order_release);
+  }
+}
+
+// In-place iterative radix-2 FFT over m_buffer
+void SpectrumAnalyzer::transform(size_t n) {
+  for (size_t i = 1, j = 0; i < n; ++i) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) {
+      std::swap(m_buffer[2 * i], m_buffer[2 * j]);
+      std::swap(m_buffer[2 * i + 1], m_buffer[2 * j + 1]);
+    }
+  }
+
+  for (size_t len = 2; len <= n; len <<= 1) {
+    float angle = -2.0f * (float)M_PI / len;
+    for (size_t k = 0; k < len / 2; ++k) {
+      float wr = cosf(angle * k);
+      float wi = sinf(angle * k);
+      for (size_t i = k; i < n; i += len) {
+        float *a = &m_buffer[2 * i];
+        float *b = &m_buffer[2 * (i + len / 2)];
+        float tr = b[0] * wr - b[1] * wi;
+        float ti = b[0] * wi + b[1] * wr;
+        b[0] = a[0] - tr;
+        b[1] = a[1] - ti;
+        a[0] += tr;
+        a[1] += ti;
+      }
+    }
+  }
+}
+
+void SpectrumAnalyzer::analyse() {
+  size_t n = m_length;
+  float sampleHz = (m_lastUs > m_firstUs) ? (n - 1) * 1e6f / (float)(m_lastUs - m_firstUs) : 0.0f;
+  uint32_t start = ESP.getCycleCount();
+
+  // Remove the mean so DC leakage doesn't hide the low bins, then a Hann window
+  float mean = 0.0f;
+  for (size_t i = 0; i < n; ++i) mean += m_buffer[2 * i];
+  mean /= n;
+  for (size_t i = 0; i < n; ++i) {
+    float w = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / (n - 1));
+    m_buffer[2 * i] = (m_buffer[2 * i] - mean) * w;
+  }
+
+  transform(n);
+
+  // Single-sided amplitude in counts: x2 for the folded half, /0.5 for the Hann coherent gain.
+  // Packed into the front of the buffer, each bin is read before anything lands on it
+  size_t bins = n / 2;
+  float *amplitude = m_buffer;
+  float power = 0.0f;
+  for (size_t k = 0; k < bins; ++k) {
+    float re = m_buffer[2 * k], im = m_buffer[2 * k + 1];
+    amplitude[k] = 4.0f * sqrtf(re * re + im * im) / n;
+    if (k > 0) power += amplitude[k] * amplitude[k] / 2.0f;
+  }
+  // The Hann window's noise bandwidth is 1.5 bins
+  float rms = sqrtf(power / 1.5f);
+
+  // Strongest local maxima, frequency refined with a parabola through the peak and its neighbours
+  float peakHz[MAX_PEAKS] = {0}, peakAmp[MAX_PEAKS] = {0};
+  size_t numPeaks = 0;
+  for (size_t k = 2; k + 1 < bins; ++k) {
+    float a = amplitude[k - 1], b = amplitude[k], c = amplitude[k + 1];
+    if (b <= a || b < c) continue;
+    size_t slot;
+    if (numPeaks < MAX_PEAKS) {
+      slot = numPeaks++;
+    } else if (b > peakAmp[MAX_PEAKS - 1]) {
+      slot = MAX_PEAKS - 1;
+    } else {
+      continue;
+    }
+    float denom = a - 2.0f * b + c;
+    float delta = (denom != 0.0f) ? 0.5f * (a - c) / denom : 0.0f;
+    peakHz[slot] = (k + delta) * sampleHz / n;
+    peakAmp[slot] = b;
+    for (size_t i = slot; i > 0 && peakAmp[i] > peakAmp[i - 1]; --i) {
+      std::swap(peakAmp[i], peakAmp[i - 1]);
+      std::swap(peakHz[i], peakHz[i - 1]);
+    }
+  }
+
+  // Median bin as the floor, peaks barely move it. Sorted in the unused back half
+  float *sorted = m_buffer + n;
+  std::copy(amplitude + 1, amplitude + bins, sorted);
+  std::nth_element(sorted, sorted + (bins - 1) / 2, sorted + bins - 1);
+  float floor = sorted[(bins - 1) / 2];
+
+  uint32_t cycles = ESP.getCycleCount() - start;
+
+  // Stored counts carry the oversampling and any fraction bits, so they are no measure of ADC LSBs.
+  // Everything is reported in units, at the captured level so it's also right on a calibration
+  // curve, and the rms in volts at the ADC input as well
+  ChannelConverter converter(m_processors, m_lsbV);
+  float unitsPerCount = fabsf(converter.toUnits(m_channel, lroundf(mean) + 1) - converter.toUnits(m_channel, lroundf(mean)));
+  float voltsPerCount = m_lsbV[m_channel];
+
+  char text[240];
+  int len = snprintf(text, sizeof(text), "spec CH%d %u @ %.1f Hz: rms %.4g (%.2f uV), floor %.3g/bin, peaks", m_channel + 1, (unsigned)n, sampleHz, rms * unitsPerCount, rms * voltsPerCount * 1e6f,
+                     floor * unitsPerCount);
+  for (size_t i = 0; i < numPeaks && len < (int)sizeof(text); ++i) {
+    len += snprintf(text + len, sizeof(text) - len, " %.1fHz=%.3g", peakHz[i], peakAmp[i] * unitsPerCount);
+  }
+  ESP_LOGI(TAG, "%s (%u cycles)", text, cycles);
+  if (m_handler) m_handler(text, m_handlerArg);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <atomic>
+
+#include "ChannelConverter.hpp"
+#include "adcProcessor.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// On-device FFT of one channel for chasing interference without pulling the CSV off the card.
+// A command picks the channel and length; the analog task copies that channel's next samples
+// into a scratch buffer as it logs them, and a low priority worker task windows and transforms
+// them and reports the strongest peaks and the noise floor. Logging never waits on the analysis.
+// One capture at a time.
+class SpectrumAnalyzer {
+ public:
+  static constexpr size_t MAX_LENGTH = 2048;
+  static constexpr size_t MAX_PEAKS = 5;
+
+  typedef void (*ResultHandler)(const char *text, void *arg);
+
+  // `lsbV` is volts per stored count for each channel, as given to ChannelConverter
+  SpectrumAnalyzer(adcProcessor *const *processors, const float *lsbV) : m_processors(processors), m_lsbV(lsbV) {}
+  ~SpectrumAnalyzer();
+
+  // Allocate the scratch buffer (PSRAM first) and start the worker task
+  bool begin();
+  // Called from the worker task with the one-line summary
+  void setResultHandler(ResultHandler handler, void *arg) {
+    m_handler = handler;
+    m_handlerArg = arg;
+  }
+
+  // Any task: capture `length` (a power of two, 64 to MAX_LENGTH) samples of `channel` (0-7)
+  bool start(int channel, size_t length);
+  bool busy() const { return m_state.load(std::memory_order_acquire) != State::IDLE; }
+
+  // Analog task: every sample, cheap when no capture is running
+  void feed(uint64_t timestampUs, const int32_t *counts, uint8_t mask);
+
+ private:
+  enum class State : uint8_t { IDLE = 0, CAPTURING = 1, ANALYSING = 2 };
+
+  void taskLoop();
+  void analyse();
+  void transform(size_t n);
+
+  adcProcessor *const *m_processors;
+  const float *m_lsbV;
+
+  float *m_buffer = nullptr;  // interleaved re, im
+  TaskHandle_t m_taskHandle = nullptr;
+  ResultHandler m_handler = nullptr;
+  void *m_handlerArg = nullptr;
+
+  std::atomic<State> m_state{State::IDLE};
+  int m_channel = 0;
+  size_t m_length = 0;
+  size_t m_count = 0;
+  uint64_t m_firstUs = 0;
+  uint64_t m_lastUs = 0;
+
+  static constexpr const char *TAG = "SpectrumAnalyzer";
+};
@@ -0,0 +1,53 @@
+#include "WindowStats.hpp"
+
+void WindowStats::add(uint64_t timestampUs, const float *units, uint8_t mask) {
+  for (uint8_t active = mask; active; active &= active - 1) {
+    size_t i = __builtin_ctz(active);
+    Accumulator &acc = m_acc[i];
+    float x = units[i];
+    if (acc.count == 0 || x < acc.min) acc.min = x;
+    if (acc.count == 0 || x > acc.max) acc.max = x;
+    acc.sum += x;
+    acc.sumSq += x * x;
+    acc.count++;
+  }
+
+  // Only an atomic load per sample until somebody asks
+  if (m_waiter.load(std::memory_order_relaxed) == nullptr) return;
+  TaskHandle_t waiter = m_waiter.exchange(nullptr, std::memory_order_acq_rel);
+  if (waiter == nullptr) return;
+
+  Window window = {};
+  window.startUs = m_startUs;
+  window.endUs = timestampUs;
+  for (size_t i = 0; i < NUM_CHANNELS; ++i) {
+    const Accumulator &acc = m_acc[i];
+    window.count[i] = acc.count;
+    if (acc.count == 0) continue;
+    window.min[i] = acc.min;
+    window.max[i] = acc.max;
+    window.mean[i] = acc.sum / acc.count;
+    window.rms[i] = sqrtf(std::max(0.0f, acc.sumSq / acc.count));
+    m_acc[i] = Accumulator();
+  }
+  m_startUs = timestampUs;
+
+  m_window.write(window);
+  xTaskNotifyGive(waiter);
+}
+
+bool WindowStats::cut(Window &window, TickType_t timeout) {
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  ulTaskNotifyTake(pdTRUE, 0);  // drop a notification left over from a cut that timed out
+  m_waiter.store(self, std::memory_order_release);
+
+  if (ulTaskNotifyTake(pdTRUE, timeout) == 0) {
+    // Withdraw the request, unless the analog task took it in the meantime and is about to notify
+    TaskHandle_t expected = self;
+    if (m_waiter.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel)) return false;
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+
+  m_window.read(window);
+  return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <atomic>
+
+#include "SeqLock.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Min, max, mean and RMS of every channel in units over a window of samples, so a status report
+// covers everything since the last one rather than a single point. Folding a sample in is O(1) per
+// channel and never blocks. Another task cuts the window: the analog task closes it at its next
+// sample, publishes it through a SeqLock and starts the next one straight away, so nothing falls
+// between two windows.
+class WindowStats {
+ public:
+  static constexpr size_t NUM_CHANNELS = 8;
+
+  struct Window {
+    uint64_t startUs;  // sample timestamps, the window covers (startUs, endUs]
+    uint64_t endUs;
+    uint32_t count[NUM_CHANNELS];  // 0 when the channel wasn't sampled, the rest is then 0 too
+    float min[NUM_CHANNELS];
+    float max[NUM_CHANNELS];
+    float mean[NUM_CHANNELS];
+    float rms[NUM_CHANNELS];
+  };
+
+  // Analog task: fold in `units` for the channels in `mask`, then cut the window if asked to
+  void add(uint64_t timestampUs, const float *units, uint8_t mask);
+
+  // Any other task: close the running window at the analog task's next sample and copy it out.
+  // False if no sample came within `timeout`. Uses the calling task's notification
+  bool cut(Window &window, TickType_t timeout);
+
+ private:
+  struct Accumulator {
+    uint32_t count = 0;
+    float min = 0.0f;
+    float max = 0.0f;
+    float sum = 0.0f;
+    float sumSq = 0.0f;
+  };
+
+  Accumulator m_acc[NUM_CHANNELS];
+  uint64_t m_startUs = 0;
+
+  std::atomic<TaskHandle_t> m_waiter{nullptr};  // task waiting on a cut
+  SeqLock<Window> m_window;
+};
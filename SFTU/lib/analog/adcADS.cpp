@@ -1,10 +1,12 @@
 #include "adcADS.hpp"
 
+// Data rate in SPS for each RATE_ADS1115_xxx code, indexed by code >> 5
+static constexpr uint16_t ADS1115_SPS[8] = {8, 16, 32, 64, 128, 250, 475, 860};
+
 adcADS::adcADS(TwoWire &Wire) {
   m_I2C_BUS = &Wire;
-  m_adc = new Adafruit_ADS1115();
   m_adcMutex = xSemaphoreCreateMutex();
-  //
+  updateConfigCache();
 }
 
 void adcADS::init(uint8_t addr) {
@@ -12,40 +14,115 @@ void adcADS::init(uint8_t addr) {
   m_I2C_BUS->beginTransmission(0x08);  // Hs controller code, not acknowledged
   m_I2C_BUS->endTransmission();
 
-  if (!m_adc->begin(addr, m_I2C_BUS)) {
+  m_addr = addr;
+  m_pointer = -1;
+
+  m_I2C_BUS->beginTransmission(m_addr);
+  if (m_I2C_BUS->endTransmission() != 0) {
     Serial.println("Failed to initialise ADS1115.");
   }
 
   setInputConfig();
 
+  // Thresholds with Hi_thresh MSB set and Lo_thresh MSB clear put ALERT/RDY in conversion-ready mode.
+  // They never change so they are written once here rather than with every conversion.
+  writeRegister(ADS1X15_REG_POINTER_HITHRESH, 0x8000);
+  writeRegister(ADS1X15_REG_POINTER_LOWTHRESH, 0x0000);
+
   Serial.println("ADS1115 initialised successfully!");
 }
 
 void adcADS::setInputConfig(adsGain_t gain, uint8_t dataRate) {
-  m_adc->setGain(gain);
-  m_adc->setDataRate(dataRate);
+  m_gain = gain;
+  m_rateBits = dataRate & ADS1X15_REG_CONFIG_RATE_MASK;
+  updateConfigCache();
+}
+
+void adcADS::updateConfigCache() {
+  // Gain bits are left out so each conversion can OR in its own, see beginConversion()
+  uint16_t base = ADS1X15_REG_CONFIG_OS_SINGLE | ADS1X15_REG_CONFIG_MODE_SINGLE | m_rateBits | ADS1X15_REG_CONFIG_CQUE_1CONV | ADS1X15_REG_CONFIG_CLAT_NONLAT | ADS1X15_REG_CONFIG_CPOL_ACTVLOW | ADS1X15_REG_CONFIG_CMODE_TRAD;
+  for (uint16_t i = 0; i < 8; ++i) m_configCache[i] = base | (i << 12);
+  m_lsbV = lsbForGain(m_gain);
+
+  m_rate = ADS1115_SPS[m_rateBits >> 5];
+  m_conversionUs = conversionUsAt(m_rate);
+}
+
+uint16_t adcADS::dataRateSps(size_t i) { return ADS1115_SPS[std::min(i, NUM_DATA_RATES - 1)]; }
+
+float adcADS::lsbForGain(adsGain_t gain) {
+  float fsRange;
+  switch (gain) {
+    case GAIN_TWOTHIRDS:
+      fsRange = 6.144f;
+      break;
+    case GAIN_ONE:
+      fsRange = 4.096f;
+      break;
+    case GAIN_TWO:
+      fsRange = 2.048f;
+      break;
+    case GAIN_FOUR:
+      fsRange = 1.024f;
+      break;
+    case GAIN_EIGHT:
+      fsRange = 0.512f;
+      break;
+    case GAIN_SIXTEEN:
+      fsRange = 0.256f;
+      break;
+    default:
+      fsRange = 0.0f;
+  }
+  return fsRange / 32768.0f;
+}
+
+void adcADS::writeRegister(uint8_t reg, uint16_t value) {
+  m_I2C_BUS->beginTransmission(m_addr);
+  m_I2C_BUS->write(reg);
+  m_I2C_BUS->write((uint8_t)(value >> 8));
+  m_I2C_BUS->write((uint8_t)(value & 0xFF));
+  m_I2C_BUS->endTransmission();
+  m_pointer = reg;
+  m_i2cTransactions++;
+}
+
+uint16_t adcADS::readRegister(uint8_t reg) const {
+  // The pointer register sticks, so a repeat read of the same register is a single transaction
+  if (m_pointer != reg) {
+    m_I2C_BUS->beginTransmission(m_addr);
+    m_I2C_BUS->write(reg);
+    m_I2C_BUS->endTransmission(false);
+    m_pointer = reg;
+    m_i2cTransactions++;
+  }
+
+  m_i2cTransactions++;
+  if (m_I2C_BUS->requestFrom(m_addr, (size_t)2) != 2) return 0;
+  uint16_t hi = m_I2C_BUS->read();
+  uint16_t lo = m_I2C_BUS->read();
+  return (hi << 8) | lo;
 }
 
+int16_t adcADS::readConversion() { return (int16_t)readRegister(ADS1X15_REG_POINTER_CONVERT); }
+
+void adcADS::setTimedRead(bool enabled) { m_timedRead = enabled; }
+
 void adcADS::startContinuous(const uint16_t mux) {
   // Start continuous ADC reading
   continuousMode = true;
-  m_adc->startADCReading(mux, continuousMode);
+  uint16_t config = (m_configCache[(mux >> 12) & 0x7] & ~ADS1X15_REG_CONFIG_MODE_MASK) | m_gain | ADS1X15_REG_CONFIG_MODE_CONTIN;
+  writeRegister(ADS1X15_REG_POINTER_CONFIG, config);
 }
 
 float adcADS::readNewVolt(const uint16_t mux) {
   SemaphoreGuard Guard_adc(m_adcMutex);
   if (Guard_adc.acquired()) {
-    continuousMode = false;
-    m_adc->startADCReading(mux, continuousMode);
-
-    // Wait for the conversion to complete
-    while (!m_adc->conversionComplete()) {
-      // NOTE: This slows things slightly, but atleast we aren't blocking
-      vTaskDelay(pdMS_TO_TICKS(1));  // Yield to other tasks
-    }
+    beginConversion(mux, m_gain);
+    waitConversion();
     // ESP_LOGD(TAG, "ADC conversion complete for mux %d", mux);
 
-    m_lastResultV = m_adc->computeVolts(m_adc->getLastConversionResults());
+    m_lastResultV = countsToVolts(readConversion());
     return m_lastResultV;
   } else {
     ESP_LOGE(TAG, "Failed to acquire ADC mutex in getAverageVolt");
@@ -53,10 +130,141 @@ float adcADS::readNewVolt(const uint16_t mux) {
   }
 }
 
+bool adcADS::startConversion(const uint16_t mux) { return startConversion(mux, m_gain); }
+
+bool adcADS::startConversion(const uint16_t mux, adsGain_t gain) {
+  if (xSemaphoreTake(m_adcMutex, mutexTimeOut) != pdTRUE) {
+    ESP_LOGE(TAG, "Failed to acquire ADC mutex in startConversion");
+    return false;
+  }
+
+  beginConversion(mux, gain);
+  m_convInFlight = true;
+  return true;
+}
+
+int16_t adcADS::finishConversion() {
+  if (!m_convInFlight) return 0;
+
+  waitConversion();
+  int16_t counts = readConversion();
+  m_convStats.i2cTransactions += m_i2cTransactions;
+
+  m_convInFlight = false;
+  xSemaphoreGive(m_adcMutex);
+  return counts;
+}
+
+void adcADS::beginConversion(const uint16_t mux, adsGain_t gain) {
+  continuousMode = false;
+
+  if (m_rdyPin >= 0) {
+    // Drop any edge left over from a conversion nobody waited on
+    taskNotifyClearBits(m_notifyBit);
+    m_convReady = false;
+    m_waitingTask = xTaskGetCurrentTaskHandle();
+  }
+
+  m_i2cTransactions = 0;
+  m_convStartUs = micros();
+  writeRegister(ADS1X15_REG_POINTER_CONFIG, m_configCache[(mux >> 12) & 0x7] | gain);
+}
+
+bool adcADS::waitConversion() {
+  bool ready = false;
+
+  if (m_timedRead) {
+    // Result is guaranteed to be there once the worst case conversion time has passed. Whole ticks
+    // are slept so slow rates leave the core to the other tasks, only the part of a tick a delay
+    // can't resolve is spun. vTaskDelay(n) wakes up to a tick early, never late
+    const uint32_t tickUs = portTICK_PERIOD_MS * 1000;
+    uint32_t elapsedUs = micros() - m_convStartUs;
+    if (elapsedUs < m_conversionUs && m_conversionUs - elapsedUs >= tickUs) {
+      vTaskDelay((m_conversionUs - elapsedUs) / tickUs);
+      elapsedUs = micros() - m_convStartUs;
+    }
+    if (elapsedUs < m_conversionUs) delayMicroseconds(m_conversionUs - elapsedUs);
+    m_convDoneUs = m_convStartUs + m_conversionUs;
+    ready = true;
+  } else if (m_rdyPin >= 0) {
+    // The flag covers the case where our bit was already consumed while waiting on the other ADC
+    ready = m_convReady || taskNotifyWaitBits(m_notifyBit, ADS_RDY_TIMEOUT);
+    m_waitingTask = nullptr;
+    if (ready) {
+      m_rdyMisses = 0;
+    } else {
+      m_convStats.rdyTimeouts++;
+      // Every miss costs a full ADS_RDY_TIMEOUT, don't keep paying it if the line isn't connected
+      if (++m_rdyMisses >= ADS_RDY_MAX_MISSES) disableReadyInterrupt();
+    }
+  }
+
+  if (!ready) {
+    // Wait for the conversion to complete
+    while (!isReady()) {
+      // NOTE: This slows things slightly, but atleast we aren't blocking
+      vTaskDelay(pdMS_TO_TICKS(1));  // Yield to other tasks
+    }
+    m_convDoneUs = micros();
+  }
+
+  uint32_t latencyUs = micros() - m_convStartUs;
+  m_convStats.count++;
+  m_convStats.lastUs = latencyUs;
+  m_convStats.totalUs += latencyUs;
+  if (latencyUs > m_convStats.maxUs) m_convStats.maxUs = latencyUs;
+
+  return ready;
+}
+
+void adcADS::enableReadyInterrupt(int8_t rdyPin, uint32_t notifyBit) {
+  if (rdyPin < 0) return;
+
+  m_rdyPin = rdyPin;
+  m_notifyBit = notifyBit;
+
+  // ALERT/RDY is open drain and pulses low at the end of each single-shot conversion
+  pinMode(m_rdyPin, INPUT_PULLUP);
+  attachInterruptArg(digitalPinToInterrupt(m_rdyPin), adcADS::readyISR, this, FALLING);
+
+  ESP_LOGI(TAG, "ALERT/RDY interrupt enabled on pin %d", m_rdyPin);
+}
+
+void adcADS::disableReadyInterrupt() {
+  ESP_LOGW(TAG, "ALERT/RDY on pin %d missed %u conversions in a row, timing conversions instead", m_rdyPin, (unsigned)m_rdyMisses);
+  detachInterrupt(digitalPinToInterrupt(m_rdyPin));
+  m_rdyPin = -1;
+  m_waitingTask = nullptr;
+  m_rdyMisses = 0;
+  m_timedRead = true;
+}
+
+void IRAM_ATTR adcADS::readyISR(void *arg) {
+  adcADS *self = static_cast<adcADS *>(arg);
+  TaskHandle_t task = self->m_waitingTask;
+  if (task == nullptr) return;
+  self->m_convDoneUs = micros();
+  self->m_convReady = true;
+
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+  xTaskNotifyFromISR(task, self->m_notifyBit, eSetBits, &xHigherPriorityTaskWoken);
+  if (xHigherPriorityTaskWoken) portYIELD_FROM_ISR();
+}
+
+ConversionStats adcADS::getConversionStats() {
+  SemaphoreGuard Guard_adc(m_adcMutex);
+  return m_convStats;
+}
+
+void adcADS::resetConversionStats() {
+  SemaphoreGuard Guard_adc(m_adcMutex);
+  m_convStats = ConversionStats();
+}
+
 float adcADS::getLastVolt() {
   SemaphoreGuard Guard_adc(m_adcMutex);
   if (Guard_adc.acquired()) {
-    m_lastResultV = m_adc->computeVolts(m_adc->getLastConversionResults());
+    m_lastResultV = countsToVolts(readConversion());
     return m_lastResultV;
   } else {
     ESP_LOGE(TAG, "Failed to acquire ADC mutex in getAverageVolt");
@@ -65,22 +273,23 @@ float adcADS::getLastVolt() {
 }
 
 bool adcADS::setDataRate(uint16_t rate) {
+  uint16_t rateBits;
   if (rate <= 8) {
-    m_rate = RATE_ADS1115_8SPS;
+    rateBits = RATE_ADS1115_8SPS;
   } else if (rate <= 16) {
-    m_rate = RATE_ADS1115_16SPS;
+    rateBits = RATE_ADS1115_16SPS;
   } else if (rate <= 32) {
-    m_rate = RATE_ADS1115_32SPS;
+    rateBits = RATE_ADS1115_32SPS;
   } else if (rate <= 64) {
-    m_rate = RATE_ADS1115_64SPS;
+    rateBits = RATE_ADS1115_64SPS;
   } else if (rate <= 128) {
-    m_rate = RATE_ADS1115_128SPS;
+    rateBits = RATE_ADS1115_128SPS;
   } else if (rate <= 250) {
-    m_rate = RATE_ADS1115_250SPS;
+    rateBits = RATE_ADS1115_250SPS;
   } else if (rate <= 475) {
-    m_rate = RATE_ADS1115_475SPS;
+    rateBits = RATE_ADS1115_475SPS;
   } else if (rate <= 860) {
-    m_rate = RATE_ADS1115_860SPS;
+    rateBits = RATE_ADS1115_860SPS;
   } else {
     ESP_LOGE(TAG,
              "Invalid data rate: %d. Valid rates are 8, 16, 32, 64, 128, 250, 475, "
@@ -89,12 +298,16 @@ bool adcADS::setDataRate(uint16_t rate) {
     return false;
   }
 
-  m_adc->setDataRate(m_rate);
+  m_rateBits = rateBits;
+  updateConfigCache();
   ESP_LOGI(TAG, "Data rate set to %d SPS", m_rate);
   return true;
 }
 
-bool adcADS::isReady() const { return m_adc->conversionComplete(); }
+bool adcADS::isReady() const {
+  // OS bit reads back as 1 once the device is idle again
+  return (readRegister(ADS1X15_REG_POINTER_CONFIG) & ADS1X15_REG_CONFIG_OS_MASK) != 0;
+}
 
 int adcADS::getResolution() const {
   // ADS1115 has 16-bit resolution
@@ -125,7 +338,8 @@ bool adcADS::setGain(int gain) {
       return false;
   }
 
-  m_adc->setGain(adsGain);
+  m_gain = adsGain;
+  updateConfigCache();
   ESP_LOGI(TAG, "Gain set to %d", gain);
   return true;
 }
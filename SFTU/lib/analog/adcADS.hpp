@@ -1,13 +1,30 @@
 #pragma once
 
+// Only the register and field definitions are used, the driver talks to the ADS1115 directly
 #include <Adafruit_ADS1X15.h>
 
 #include "SemaphoreGuard.hpp"
+#include "TaskNotify.hpp"
 #include "adcBase.hpp"
 
 #define ADS0_ADDR 0x48
 #define ADS1_ADDR 0x49
 
+// Longest we wait on ALERT/RDY before falling back to polling (8 SPS worst case is 125 ms)
+#define ADS_RDY_TIMEOUT pdMS_TO_TICKS(150)
+// Timeouts in a row after which ALERT/RDY is taken to be unwired and conversions are timed instead
+#define ADS_RDY_MAX_MISSES 3
+
+// Latency of single-shot conversions, start of conversion to result available
+struct ConversionStats {
+  uint32_t count = 0;
+  uint32_t lastUs = 0;
+  uint32_t maxUs = 0;
+  uint64_t totalUs = 0;
+  uint32_t rdyTimeouts = 0;      // conversions where ALERT/RDY never fired
+  uint32_t i2cTransactions = 0;  // bus transactions (writes and reads) spent on these conversions
+};
+
 class adcADS : public adcBase {
  public:
   adcADS(TwoWire &Wire);
@@ -40,12 +57,90 @@ class adcADS : public adcBase {
 
   float getAverageVolt(uint16_t numSamples, const uint16_t mux);
 
+  // Use the ALERT/RDY pin as a conversion-ready interrupt instead of polling over I2C.
+  // The ISR sets `notifyBit` on whichever task is waiting for the conversion. If the pin misses
+  // ADS_RDY_MAX_MISSES conversions in a row it is released and the driver switches to timed reads.
+  void enableReadyInterrupt(int8_t rdyPin, uint32_t notifyBit);
+  bool readyInterruptEnabled() const { return m_rdyPin >= 0; }
+
+  // Skip completion checks and just wait out the conversion time for the configured data rate.
+  // Used when ALERT/RDY isn't wired, saves polling the config register over I2C.
+  void setTimedRead(bool enabled);
+
+  // Start a single-shot conversion and return without waiting for it. The ADC stays locked until
+  // finishConversion() so a second ADC can convert in the meantime.
+  bool startConversion(const uint16_t mux);
+  // Same with a PGA setting for this conversion only, for channels that range their own gain
+  bool startConversion(const uint16_t mux, adsGain_t gain);
+
+  // Wait for the conversion begun by startConversion() and return the raw result, see getLsbV()
+  int16_t finishConversion();
+
+  // Volts per count at the configured gain
+  float getLsbV() const { return m_lsbV; }
+  static float lsbForGain(adsGain_t gain);
+
+  // micros() at which the last finished conversion completed. Taken in the RDY interrupt when wired
+  uint32_t lastConversionUs() const { return m_convDoneUs; }
+
+  // Worst case time for one conversion at the configured data rate
+  uint32_t getConversionUs() const { return m_conversionUs; }
+  // Same for any data rate: the internal oscillator is only good to 10%, plus a little for the I2C
+  // write that starts it. The rates the ADS1115 offers follow, slowest first
+  static uint32_t conversionUsAt(uint16_t sps) { return (uint32_t)(1.1e6f / sps) + 50; }
+  // CPU time a timed read spends spinning at that data rate, on average. It sleeps whole ticks and
+  // wakes up to a tick early, so what's left is the sub-tick remainder plus half a tick
+  static uint32_t timedSpinUsAt(uint16_t sps) {
+    uint32_t conversionUs = conversionUsAt(sps);
+    uint32_t tickUs = portTICK_PERIOD_MS * 1000;
+    return (conversionUs < tickUs) ? conversionUs : conversionUs % tickUs + tickUs / 2;
+  }
+  static constexpr size_t NUM_DATA_RATES = 8;
+  static uint16_t dataRateSps(size_t i);
+
+  ConversionStats getConversionStats();
+  void resetConversionStats();
+
  private:
-  Adafruit_ADS1115 *m_adc;
-  int m_mux;
+  void beginConversion(const uint16_t mux, adsGain_t gain);
+  bool waitConversion();
+  static void IRAM_ATTR readyISR(void *arg);
+  void disableReadyInterrupt();
+
+  void writeRegister(uint8_t reg, uint16_t value);
+  uint16_t readRegister(uint8_t reg) const;
+  int16_t readConversion();
+  float countsToVolts(int16_t counts) const { return counts * m_lsbV; }
+
+  // Rebuild the config words after a gain or data rate change
+  void updateConfigCache();
+
+  uint8_t m_addr = ADS0_ADDR;
   TwoWire *m_I2C_BUS;
   bool continuousMode = false;
   SemaphoreHandle_t m_adcMutex = nullptr;
 
-  // Add any private members or methods needed for the ADS ADC implementation
+  adsGain_t m_gain = GAIN_TWO;
+  uint16_t m_rateBits = RATE_ADS1115_860SPS;
+  float m_lsbV = 0.0f;
+  uint32_t m_conversionUs = 0;  // worst case conversion time at the current data rate
+
+  // Single-shot config word, less the PGA bits, for each of the 8 mux settings, indexed by mux >> 12
+  uint16_t m_configCache[8] = {0};
+
+  // Register the device pointer is currently set to, lets repeat reads skip the pointer write
+  mutable int16_t m_pointer = -1;
+  mutable uint32_t m_i2cTransactions = 0;
+
+  int8_t m_rdyPin = -1;
+  uint32_t m_notifyBit = 0;
+  volatile TaskHandle_t m_waitingTask = nullptr;
+  volatile bool m_convReady = false;
+  bool m_convInFlight = false;
+  bool m_timedRead = false;
+  uint8_t m_rdyMisses = 0;  // consecutive conversions ALERT/RDY didn't signal
+
+  uint32_t m_convStartUs = 0;
+  volatile uint32_t m_convDoneUs = 0;
+  ConversionStats m_convStats;
 };
\ No newline at end of file
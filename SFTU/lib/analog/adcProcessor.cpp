@@ -1,18 +1,38 @@
 #include "adcProcessor.hpp"
 
+std::atomic<uint32_t> adcProcessor::s_generation{0};
+portMUX_TYPE adcProcessor::s_updateMux = portMUX_INITIALIZER_UNLOCKED;
+
+void adcProcessor::beginUpdate() {
+  portENTER_CRITICAL(&s_updateMux);
+  s_generation.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void adcProcessor::endUpdate() {
+  s_generation.fetch_add(1, std::memory_order_release);
+  portEXIT_CRITICAL(&s_updateMux);
+}
+
 adcProcessor::adcProcessor() {
   m_units_per_V = 0.0f;  // Initialize units per volt
   m_Voffset = 0.0f;      // Offset voltage for calibration
 }
 
 float adcProcessor::processVtoUnits(float voltage, float units_per_V) {
-  if (units_per_V < 0) return (voltage - m_Voffset) * m_units_per_V;
-  return (voltage - m_Voffset) * units_per_V;
+  float units = voltsToUnits(voltage, units_per_V);
+  return m_filters.numStages() ? m_filters.process(units) : units;
+}
+
+float adcProcessor::voltsToUnits(float voltage, float units_per_V) const {
+  if (units_per_V < 0) units_per_V = m_units_per_V;
+  return m_curve.active() ? m_curve.evaluate(voltage - m_Voffset) : (voltage - m_Voffset) * units_per_V;
 }
 
 void adcProcessor::tareVolts(float voltage) {
+  beginUpdate();
   m_Voffset = voltage;
-  //
+  endUpdate();
 }
 
 // use commander to call this function
@@ -21,12 +41,28 @@ float adcProcessor::calibrate(float realUnits, float voltage) {
 
   float taredVoltage = voltage - m_Voffset;
   ESP_LOGI(TAG, "Calibrating with real units: %.3f U, tared voltage: %.3f V", realUnits, taredVoltage);
+  beginUpdate();
   m_units_per_V = realUnits / (taredVoltage);
+  endUpdate();
   ESP_LOGI(TAG, "Calibration complete: Units_per_V = %.3f N/V", m_units_per_V);
   return m_units_per_V;
 }
 
 void adcProcessor::setScale(float scale) {
+  beginUpdate();
   m_units_per_V = scale;
+  endUpdate();
   ESP_LOGI(TAG, "Cell scale set to: %.3f N/V", m_units_per_V);
+}
+
+void adcProcessor::setCurve(const CalibrationCurve &curve) {
+  beginUpdate();
+  m_curve = curve;
+  endUpdate();
+}
+
+void adcProcessor::configure(float scale, const CalibrationCurve &curve, float offset) {
+  m_units_per_V = scale;
+  m_curve = curve;
+  m_Voffset = offset;
 }
\ No newline at end of file
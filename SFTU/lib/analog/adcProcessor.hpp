@@ -1,16 +1,50 @@
 #pragma once
 #include <Arduino.h>
 
+#include <atomic>
+
+#include "CalibrationCurve.hpp"
+#include "FilterChain.hpp"
+#include "freertos/FreeRTOS.h"
+
 class adcProcessor {
  public:
   adcProcessor();
   float processVtoUnits(float voltage, float units_per_V = -1.0f);
+  // processVtoUnits() without the filters
+  float voltsToUnits(float voltage, float units_per_V = -1.0f) const;
   void tareVolts(float voltage);
   float calibrate(float realUnits, float voltage);
   void setScale(float scale);
+  // Replaces the linear scale while active, clear() it to go back
+  void setCurve(const CalibrationCurve &curve);
+  // Scale, curve and offset in one go for a channel being set up. Only between beginUpdate() and
+  // endUpdate(), so the caller can change its volts per count in the same update
+  void configure(float scale, const CalibrationCurve &curve, float offset);
+
+  float getOffset() const { return m_Voffset; }
+  float getScale() const { return m_units_per_V; }
+  const CalibrationCurve &getCurve() const { return m_curve; }
+
+  // Every change to what ChannelConverter copies, any processor's offset, scale or curve and the
+  // volts per count kept alongside them, goes between these two. The generation is odd while one is
+  // in progress and moves on once it's done, so cached copies know to refresh and a copy that
+  // overlapped an update is taken again. Writers on different tasks are serialised; the bracket
+  // holds a spinlock, so nothing in it may block or log
+  static void beginUpdate();
+  static void endUpdate();
+  static uint32_t generation() { return s_generation.load(std::memory_order_acquire); }
+
+  // Applied after scaling on every processVtoUnits() call, empty by default
+  FilterChain &filters() { return m_filters; }
 
  private:
   float m_units_per_V;
   float m_Voffset;
+  CalibrationCurve m_curve;
+  FilterChain m_filters;
+
+  static std::atomic<uint32_t> s_generation;
+  static portMUX_TYPE s_updateMux;
   static constexpr const char *TAG = "adcProcessor";
 };
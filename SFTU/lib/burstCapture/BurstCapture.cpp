@@ -0,0 +1,84 @@
+#include "BurstCapture.hpp"
+
+#include "esp_heap_caps.h"
+
+BurstCapture::~BurstCapture() { heap_caps_free(m_buffer); }
+
+bool BurstCapture::begin(size_t capacity, size_t recordSize, uint64_t postTriggerUs) {
+  m_state.store(State::DISABLED);
+  heap_caps_free(m_buffer);
+  m_buffer = nullptr;
+
+  size_t bytes = capacity * recordSize;
+  if (bytes == 0) return false;
+
+  // Seconds of history don't fit comfortably in internal RAM, so prefer PSRAM when the module has it
+  m_buffer = static_cast<uint8_t *>(heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+  bool inPsram = m_buffer != nullptr;
+  if (!inPsram) m_buffer = static_cast<uint8_t *>(heap_caps_malloc(bytes, MALLOC_CAP_8BIT));
+  if (m_buffer == nullptr) {
+    ESP_LOGE(TAG, "Failed to allocate %u bytes for burst capture", (unsigned)bytes);
+    return false;
+  }
+
+  m_capacity = capacity;
+  m_recordSize = recordSize;
+  m_postTriggerUs = postTriggerUs;
+  rearm();
+
+  ESP_LOGI(TAG, "Holding %u records (%u bytes) in %s", (unsigned)capacity, (unsigned)bytes, inPsram ? "PSRAM" : "internal RAM");
+  return true;
+}
+
+void IRAM_ATTR BurstCapture::trigger(BurstTrigger source) {
+  BurstTrigger expected = BurstTrigger::NONE;
+  if (m_state.load(std::memory_order_relaxed) == State::ARMED) m_pending.compare_exchange_strong(expected, source);
+}
+
+uint8_t *BurstCapture::slot() {
+  State state = m_state.load(std::memory_order_relaxed);
+  if (state != State::ARMED && state != State::POST_TRIGGER) return nullptr;
+  return &m_buffer[(m_written % m_capacity) * m_recordSize];
+}
+
+void BurstCapture::commit(uint64_t timestampUs) {
+  m_written++;
+
+  State state = m_state.load(std::memory_order_relaxed);
+  if (state == State::ARMED) {
+    BurstTrigger source = m_pending.load(std::memory_order_acquire);
+    if (source != BurstTrigger::NONE) {
+      m_source = source;
+      m_triggerUs = timestampUs;
+      m_state.store(State::POST_TRIGGER, std::memory_order_release);
+    }
+  } else if (state == State::POST_TRIGGER && timestampUs - m_triggerUs >= m_postTriggerUs) {
+    m_state.store(State::FROZEN, std::memory_order_release);
+  }
+}
+
+size_t BurstCapture::frozenSpans(const uint8_t *spans[2], size_t counts[2]) const {
+  spans[0] = spans[1] = m_buffer;
+  counts[0] = counts[1] = 0;
+  if (state() != State::FROZEN) return 0;
+
+  if (m_written <= m_capacity) {
+    counts[0] = m_written;
+  } else {
+    // Wrapped: oldest record is the one the next write would have replaced
+    size_t oldest = m_written % m_capacity;
+    spans[0] = &m_buffer[oldest * m_recordSize];
+    counts[0] = m_capacity - oldest;
+    counts[1] = oldest;
+  }
+  return counts[0] + counts[1];
+}
+
+void BurstCapture::rearm() {
+  if (m_buffer == nullptr) return;
+  m_written = 0;
+  m_triggerUs = 0;
+  m_source = BurstTrigger::NONE;
+  m_pending.store(BurstTrigger::NONE);
+  m_state.store(State::ARMED, std::memory_order_release);
+}
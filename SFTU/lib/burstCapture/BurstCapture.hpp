@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <atomic>
+
+#include "esp_attr.h"
+#include "esp_log.h"
+
+enum class BurstTrigger : uint8_t { NONE = 0, SEQUENCE = 1, ESTOP = 2, THRESHOLD = 3, COMMAND = 4 };
+
+// Always-running history of the last few seconds of packed sample records (see SampleLayout).
+// A trigger marks the current position, recording continues for the post-trigger window and the
+// buffer is then frozen so the SD task can dump it while the ring is left alone. Rearm to start
+// over. The analog task is the only writer; the SD task only reads while frozen.
+class BurstCapture {
+ public:
+  enum class State : uint8_t { DISABLED = 0, ARMED = 1, POST_TRIGGER = 2, FROZEN = 3 };
+
+  ~BurstCapture();
+
+  // Allocate room for `capacity` records of `recordSize` bytes, PSRAM first.
+  // `postTriggerUs` of data is kept after the trigger, whatever is left before it is the pre-trigger window.
+  bool begin(size_t capacity, size_t recordSize, uint64_t postTriggerUs);
+
+  // Safe from any task or ISR. Ignored unless armed, so the first trigger wins
+  void IRAM_ATTR trigger(BurstTrigger source);
+
+  // Analog task: slot for the next record, nullptr while frozen or disabled
+  uint8_t *slot();
+  // Analog task: publish the slot with the record's timestamp, handles the trigger and end of window
+  void commit(uint64_t timestampUs);
+
+  // SD task: the frozen window oldest first, as up to two contiguous spans. Returns the record count
+  size_t frozenSpans(const uint8_t *spans[2], size_t counts[2]) const;
+  void rearm();
+
+  State state() const { return m_state.load(std::memory_order_acquire); }
+  BurstTrigger source() const { return m_source; }
+  uint64_t triggerTimeUs() const { return m_triggerUs; }
+  size_t capacity() const { return m_capacity; }
+
+ private:
+  uint8_t *m_buffer = nullptr;
+  size_t m_capacity = 0;
+  size_t m_recordSize = 0;
+  uint64_t m_postTriggerUs = 0;
+
+  size_t m_written = 0;  // records committed since the last rearm
+  uint64_t m_triggerUs = 0;
+
+  std::atomic<State> m_state{State::DISABLED};
+  std::atomic<BurstTrigger> m_pending{BurstTrigger::NONE};
+  BurstTrigger m_source = BurstTrigger::NONE;
+
+  static constexpr const char *TAG = "BurstCapture";
+};
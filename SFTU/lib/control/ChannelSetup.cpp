@@ -0,0 +1,81 @@
+#include "ChannelSetup.hpp"
+
+#include <Adafruit_ADS1X15.h>
+
+// ADS1115 mux code for a channel's mode and inputs, -1 when it is unused or not wired that way
+static int resolveMux(const ChannelConfig &ch) {
+  if (ch.mode == "differential") {
+    if (ch.inputs == std::vector<int>{0, 1}) return ADS1X15_REG_CONFIG_MUX_DIFF_0_1;
+    if (ch.inputs == std::vector<int>{2, 3}) return ADS1X15_REG_CONFIG_MUX_DIFF_2_3;
+  } else if (ch.mode == "single_ended" && ch.inputs.size() == 1) {
+    if (ch.inputs[0] == 0) return ADS1X15_REG_CONFIG_MUX_SINGLE_0;
+    if (ch.inputs[0] == 1) return ADS1X15_REG_CONFIG_MUX_SINGLE_1;
+    if (ch.inputs[0] == 2) return ADS1X15_REG_CONFIG_MUX_SINGLE_2;
+    if (ch.inputs[0] == 3) return ADS1X15_REG_CONFIG_MUX_SINGLE_3;
+  }
+  return -1;
+}
+
+ChannelSetup *ChannelSetup::build(const ControlConfig &config, uint32_t id, size_t ringSize) {
+  ChannelSetup *setup = new ChannelSetup();
+  setup->id = id;
+  setup->config = config;
+
+  std::array<std::array<ChannelConfig, 4> *, 2> configs = {&setup->config.adc1_channels, &setup->config.adc2_channels};
+  for (int idx = 0; idx < 8; ++idx) {
+    ChannelConfig &ch = (*configs[idx / 4])[idx % 4];
+    ch.mux = resolveMux(ch);
+    if (ch.mux != -1) setup->activeMask |= (1 << idx);
+
+    if (!ch.name.empty()) {
+      strncpy(setup->name[idx], ch.name.c_str(), sizeof(setup->name[idx]) - 1);
+      setup->name[idx][sizeof(setup->name[idx]) - 1] = '\0';
+    } else {
+      snprintf(setup->name[idx], sizeof(setup->name[idx]), "IN%d", idx + 1);
+    }
+  }
+
+  SampleLayout &layout = setup->layout;
+  layout.numDerived = std::min(config.derived.size(), DerivedChannels::MAX_CHANNELS);
+  for (int idx = 0; idx < 8; ++idx) {
+    if (setup->activeMask & (1 << idx)) layout.addChannel(idx, (*configs[idx / 4])[idx % 4].wideCounts());
+  }
+
+  if (!setup->ring.begin(ringSize, layout.recordSize)) {
+    ESP_LOGE(TAG, "Failed to allocate the sample ring");
+  }
+  ESP_LOGI(TAG, "Setup %u records: %u active channels (%u at 32 bits), %u derived, %u bytes each, %u bytes of ring", (unsigned)id, layout.numChannels, (unsigned)__builtin_popcount(layout.wideMask),
+           layout.numDerived, (unsigned)layout.recordSize, (unsigned)(setup->ring.capacity() * layout.recordSize));
+  return setup;
+}
+
+void ChannelSetup::columns(std::vector<String> &names, std::vector<String> &units) const {
+  std::vector<std::string> stdNames = config.getChannelNames();
+  std::vector<std::string> stdUnits = config.getChannelUnits();
+
+  // Columns follow the packed record layout, so only active channels appear
+  names.clear();
+  units.clear();
+  for (int slot = 0; slot < layout.numChannels; ++slot) {
+    names.push_back(String(stdNames[layout.channel[slot]].c_str()));
+    units.push_back(String(stdUnits[layout.channel[slot]].c_str()));
+  }
+  for (int d = 0; d < layout.numDerived; ++d) {
+    names.push_back(String(config.derived[d].name.c_str()));
+    units.push_back(String(config.derived[d].units.c_str()));
+  }
+
+  // Add battery voltage column
+  names.push_back(String("Battery Voltage"));
+  units.push_back(String("V"));
+
+  // Completion time of each channel's conversion relative to the row time, for skew correction
+  for (int slot = 0; slot < layout.numChannels; ++slot) {
+    names.push_back(String("dt ") + String(stdNames[layout.channel[slot]].c_str()));
+    units.push_back(String("us"));
+  }
+
+  // 1 on rows logged before the auto-tare offsets were fixed
+  names.push_back(String("Pre-tare"));
+  units.push_back(String("flag"));
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <atomic>
+#include <vector>
+
+#include "CalibrationCurve.hpp"
+#include "ControlConfig.hpp"
+#include "SD_Talker.hpp"
+#include "SpscRing.hpp"
+
+// Everything about one channel configuration that the tasks share: the config it was built from
+// (muxes resolved), the packed record layout and the ring those records travel through to the SD
+// task. It is built whole before it's published through Control::m_setup and the config and layout
+// never change afterwards, so any task can read one it has loaded without locking.
+// A config reload builds a new one and the analog task swaps it in between scans. The old one is
+// retired: the SD task writes out what is left in its ring and moves on to the new setup's ring in a
+// new log segment. It is only deleted once the reload after that retires, and Control holds each
+// reload off for RELOAD_HOLDOFF_MS after the last one went live, so readers holding one for a single
+// pass have long let go.
+struct ChannelSetup {
+  uint32_t id = 0;  // 0 for the config loaded at boot, one more for each reload
+  ControlConfig config;
+  uint8_t activeMask = 0;
+  char name[8][24];  // for status lines, INn where the config has none
+  SampleLayout layout;  // conversion left for each consumer to describe
+  SpscRing ring;
+
+  // Written by the analog task as it swaps the next setup in, before any processor changes. Rows left
+  // in the ring are converted with `finalLayout` from then on
+  SampleLayout finalLayout;
+  CalibrationCurve finalCurves[8];
+  std::atomic<bool> retired{false};
+
+  // Resolve `config` and allocate the ring. ring.capacity() is 0 if that failed
+  static ChannelSetup *build(const ControlConfig &config, uint32_t id, size_t ringSize);
+
+  // Log columns for this setup's records, in the order SD_Talker::formatRecords() writes them
+  void columns(std::vector<String> &names, std::vector<String> &units) const;
+
+ private:
+  static constexpr const char *TAG = "ChannelSetup";
+};
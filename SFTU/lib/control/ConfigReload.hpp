@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <atomic>
+
+#include "esp_log.h"
+
+// Carries a request to read config.json again from the commander to the SD task, which owns the
+// card and builds the new channel setup, and the outcome back once the new channels are live.
+class ConfigReload {
+ public:
+  typedef void (*ResultHandler)(const char *text, void *arg);
+
+  // Called with each outcome, from the SD task
+  void setResultHandler(ResultHandler handler, void *arg) {
+    m_handler = handler;
+    m_handlerArg = arg;
+  }
+
+  void request() { m_requested.store(true, std::memory_order_release); }
+  // SD task: true once per request
+  bool take() { return m_requested.exchange(false, std::memory_order_acq_rel); }
+
+  void report(const char *text) {
+    ESP_LOGI(TAG, "%s", text);
+    if (m_handler) m_handler(text, m_handlerArg);
+  }
+
+ private:
+  std::atomic<bool> m_requested{false};
+  ResultHandler m_handler = nullptr;
+  void *m_handlerArg = nullptr;
+
+  static constexpr const char *TAG = "ConfigReload";
+};
@@ -24,6 +24,117 @@ std::vector<std::string> ControlConfig::getChannelUnits() const {
 #include "../SD_Talker/SD_Talker.hpp"
 #include "ControlConfig.hpp"
 
+static void readChannel(JsonObject chObj, ChannelConfig& ch) {
+  ch.name = chObj["name"] | "";
+  ch.units = chObj["units"] | "";
+  ch.mode = chObj["mode"].as<const char*>();
+  ch.inputs.clear();
+  for (JsonVariant v : chObj["inputs"].as<JsonArray>()) {
+    ch.inputs.push_back(v.as<int>());
+  }
+  ch.scale_factor = chObj["scale_factor"] | 1.0f;
+  ch.sample_rate = chObj["sample_rate"] | 0.0f;
+  ch.oversample = std::max(1, std::min(256, chObj["oversample"] | 1));
+  ch.auto_gain = chObj["auto_gain"] | false;
+  ch.tare_bias.auto_tare = false;
+  ch.tare_bias.value = 0.0f;
+  if (chObj["tare_bias"]["auto"].is<bool>()) {
+    ch.tare_bias.auto_tare = chObj["tare_bias"]["auto"];
+  } else if (chObj["tare_bias"]["value"].is<float>()) {
+    ch.tare_bias.value = chObj["tare_bias"]["value"];
+  }
+  ch.calibration.points.clear();
+  for (JsonArray pArr : chObj["calibration"]["points"].as<JsonArray>()) {
+    ch.calibration.points.emplace_back(pArr[0] | 0.0f, pArr[1] | 0.0f);
+  }
+  ch.calibration.polynomial.clear();
+  for (JsonVariant v : chObj["calibration"]["polynomial"].as<JsonArray>()) {
+    ch.calibration.polynomial.push_back(v.as<float>());
+  }
+  ch.filters.clear();
+  for (JsonObject fObj : chObj["filters"].as<JsonArray>()) {
+    FilterConfig filter;
+    filter.type = fObj["type"] | "";
+    filter.freq_hz = fObj["freq_hz"] | 0.0f;
+    filter.q = fObj["q"] | 0.7071f;
+    filter.length = fObj["length"] | 1;
+    ch.filters.push_back(filter);
+  }
+  JsonObject qObj = chObj["quiet"];
+  ch.quiet = QuietBand();
+  if (!qObj.isNull()) {
+    ch.quiet.enabled = true;
+    ch.quiet.min = qObj["min"] | -INFINITY;
+    ch.quiet.max = qObj["max"] | INFINITY;
+    ch.quiet.rate = qObj["rate"] | INFINITY;
+  }
+}
+
+static void writeChannel(JsonObject chObj, const ChannelConfig& ch) {
+  chObj["name"] = ch.name.c_str();
+  chObj["units"] = ch.units.c_str();
+  chObj["mode"] = ch.mode.c_str();
+  JsonArray inArr = chObj["inputs"].to<JsonArray>();
+  for (int v : ch.inputs) inArr.add(v);
+  chObj["scale_factor"] = ch.scale_factor;
+  if (ch.sample_rate > 0.0f) chObj["sample_rate"] = ch.sample_rate;
+  if (ch.oversample > 1) chObj["oversample"] = ch.oversample;
+  if (ch.auto_gain) chObj["auto_gain"] = true;
+  JsonObject tbObj = chObj["tare_bias"].to<JsonObject>();
+  if (ch.tare_bias.auto_tare) {
+    tbObj["auto"] = true;
+  } else {
+    tbObj["value"] = ch.tare_bias.value;
+  }
+  if (!ch.calibration.points.empty() || !ch.calibration.polynomial.empty()) {
+    JsonObject calObj = chObj["calibration"].to<JsonObject>();
+    if (!ch.calibration.points.empty()) {
+      JsonArray pArr = calObj["points"].to<JsonArray>();
+      for (const auto& point : ch.calibration.points) {
+        JsonArray p = pArr.add<JsonArray>();
+        p.add(point.first);
+        p.add(point.second);
+      }
+    }
+    if (!ch.calibration.polynomial.empty()) {
+      JsonArray cArr = calObj["polynomial"].to<JsonArray>();
+      for (float c : ch.calibration.polynomial) cArr.add(c);
+    }
+  }
+  if (!ch.filters.empty()) {
+    JsonArray fArr = chObj["filters"].to<JsonArray>();
+    for (const FilterConfig& filter : ch.filters) {
+      JsonObject fObj = fArr.add<JsonObject>();
+      fObj["type"] = filter.type.c_str();
+      if (filter.type == "moving_average") {
+        fObj["length"] = filter.length;
+      } else {
+        fObj["freq_hz"] = filter.freq_hz;
+        fObj["q"] = filter.q;
+      }
+    }
+  }
+  if (ch.quiet.enabled) {
+    JsonObject qObj = chObj["quiet"].to<JsonObject>();
+    if (std::isfinite(ch.quiet.min)) qObj["min"] = ch.quiet.min;
+    if (std::isfinite(ch.quiet.max)) qObj["max"] = ch.quiet.max;
+    if (std::isfinite(ch.quiet.rate)) qObj["rate"] = ch.quiet.rate;
+  }
+}
+
+bool ChannelConfig::sameSignal(const ChannelConfig& other) const {
+  if (mode != other.mode || inputs != other.inputs || mux != other.mux) return false;
+  if (scale_factor != other.scale_factor || sample_rate != other.sample_rate || oversample != other.oversample || auto_gain != other.auto_gain) return false;
+  if (tare_bias.auto_tare != other.tare_bias.auto_tare || tare_bias.value != other.tare_bias.value) return false;
+  if (calibration.points != other.calibration.points || calibration.polynomial != other.calibration.polynomial) return false;
+  if (filters.size() != other.filters.size()) return false;
+  for (size_t f = 0; f < filters.size(); ++f) {
+    const FilterConfig &a = filters[f], &b = other.filters[f];
+    if (a.type != b.type || a.freq_hz != b.freq_hz || a.q != b.q || a.length != b.length) return false;
+  }
+  return true;
+}
+
 ControlConfig::ControlConfig() : rf_frequency(DEFAULT_RF_FREQUENCY), sampling_rate(DEFAULT_SAMPLING_RATE), mode(DEFAULT_MODE) {
   for (int i = 0; i < 4; ++i) {
     adc1_channels[i] = default_adc1_channel(i);
@@ -32,64 +143,60 @@ ControlConfig::ControlConfig() : rf_frequency(DEFAULT_RF_FREQUENCY), sampling_ra
 }
 
 bool ControlConfig::loadFromSD(SD_Talker& sd, const char* path) {
-  if (!sd.checkFileOpen()) {
-    File file = SD.open(path, FILE_READ);
-    if (!file) return false;
-    JsonDocument doc;
-    DeserializationError err = deserializeJson(doc, file);
-    file.close();
-    if (err) return false;
-    // adc1
-    JsonArray chArr1 = doc["adc1"]["channels"];
-    int i = 0;
-    for (JsonObject chObj : chArr1) {
-      if (i >= 4) break;
-      adc1_channels[i].name = chObj["name"] | "";
-      adc1_channels[i].units = chObj["units"] | "";
-      adc1_channels[i].mode = chObj["mode"].as<const char*>();
-      adc1_channels[i].inputs.clear();
-      for (JsonVariant v : chObj["inputs"].as<JsonArray>()) {
-        adc1_channels[i].inputs.push_back(v.as<int>());
-      }
-      adc1_channels[i].scale_factor = chObj["scale_factor"] | 1.0f;
-      adc1_channels[i].tare_bias.auto_tare = false;
-      adc1_channels[i].tare_bias.value = 0.0f;
-      if (chObj["tare_bias"]["auto"].is<bool>()) {
-        adc1_channels[i].tare_bias.auto_tare = chObj["tare_bias"]["auto"];
-      } else if (chObj["tare_bias"]["value"].is<float>()) {
-        adc1_channels[i].tare_bias.value = chObj["tare_bias"]["value"];
-      }
-      ++i;
-    }
-    // adc2
-    JsonArray chArr2 = doc["adc2"]["channels"];
-    i = 0;
-    for (JsonObject chObj : chArr2) {
-      if (i >= 4) break;
-      adc2_channels[i].name = chObj["name"] | "";
-      adc2_channels[i].units = chObj["units"] | "";
-      adc2_channels[i].mode = chObj["mode"].as<const char*>();
-      adc2_channels[i].inputs.clear();
-      for (JsonVariant v : chObj["inputs"].as<JsonArray>()) {
-        adc2_channels[i].inputs.push_back(v.as<int>());
-      }
-      adc2_channels[i].scale_factor = chObj["scale_factor"] | 1.0f;
-      adc2_channels[i].tare_bias.auto_tare = false;
-      adc2_channels[i].tare_bias.value = 0.0f;
-      if (chObj["tare_bias"]["auto"].is<bool>()) {
-        adc2_channels[i].tare_bias.auto_tare = chObj["tare_bias"]["auto"];
-      } else if (chObj["tare_bias"]["value"].is<float>()) {
-        adc2_channels[i].tare_bias.value = chObj["tare_bias"]["value"];
-      }
-      ++i;
+  // The SD task owns the card, so this is safe with the log open
+  File file = SD.open(path, FILE_READ);
+  if (!file) return false;
+  JsonDocument doc;
+  DeserializationError err = deserializeJson(doc, file);
+  file.close();
+  if (err) return false;
+  JsonArray chArr1 = doc["adc1"]["channels"];
+  int i = 0;
+  for (JsonObject chObj : chArr1) {
+    if (i >= 4) break;
+    readChannel(chObj, adc1_channels[i++]);
+  }
+  JsonArray chArr2 = doc["adc2"]["channels"];
+  i = 0;
+  for (JsonObject chObj : chArr2) {
+    if (i >= 4) break;
+    readChannel(chObj, adc2_channels[i++]);
+  }
+  rf_frequency = doc["rf_frequency"] | rf_frequency;
+  sampling_rate = doc["sampling_rate"] | sampling_rate;
+  mode = doc["mode"] | mode;
+  JsonObject burstObj = doc["burst"];
+  if (!burstObj.isNull()) {
+    burst.pre_trigger_s = burstObj["pre_trigger_s"] | burst.pre_trigger_s;
+    burst.post_trigger_s = burstObj["post_trigger_s"] | burst.post_trigger_s;
+    burst.threshold_channel = burstObj["threshold_channel"] | burst.threshold_channel;
+    burst.threshold = burstObj["threshold"] | burst.threshold;
+  }
+  JsonObject burnObj = doc["burn"];
+  if (!burnObj.isNull()) {
+    burn.thrust_channel = burnObj["thrust_channel"] | burn.thrust_channel.c_str();
+    burn.pressure_channel = burnObj["pressure_channel"] | burn.pressure_channel.c_str();
+    burn.thrust_threshold = burnObj["thrust_threshold"] | burn.thrust_threshold;
+  }
+  JsonObject adaptiveObj = doc["adaptive_log"];
+  if (!adaptiveObj.isNull()) {
+    adaptive_log.enabled = adaptiveObj["enabled"] | adaptive_log.enabled;
+    adaptive_log.idle_hz = adaptiveObj["idle_hz"] | adaptive_log.idle_hz;
+    adaptive_log.pre_roll_s = adaptiveObj["pre_roll_s"] | adaptive_log.pre_roll_s;
+    adaptive_log.hold_s = adaptiveObj["hold_s"] | adaptive_log.hold_s;
+  }
+  JsonArray derivedArr = doc["derived"];
+  if (!derivedArr.isNull()) {
+    derived.clear();
+    for (JsonObject dObj : derivedArr) {
+      DerivedConfig d;
+      d.name = dObj["name"] | "";
+      d.units = dObj["units"] | "";
+      d.expr = dObj["expr"] | "";
+      if (!d.expr.empty()) derived.push_back(d);
     }
-    rf_frequency = doc["rf_frequency"] | rf_frequency;
-    sampling_rate = doc["sampling_rate"] | sampling_rate;
-    mode = doc["mode"] | mode;
-    return true;
-  } else {
-    return false;
   }
+  return true;
 }
 
 bool ControlConfig::saveToSD(SD_Talker& sd, const char* path) const {
@@ -97,43 +204,34 @@ bool ControlConfig::saveToSD(SD_Talker& sd, const char* path) const {
   File file = SD.open(path, FILE_WRITE);
   if (!file) return false;
   JsonDocument doc;
-  // adc1
   JsonArray chArr1 = doc["adc1"]["channels"].to<JsonArray>();
-  for (int i = 0; i < 4; ++i) {
-    JsonObject chObj = chArr1.add<JsonObject>();
-    chObj["name"] = adc1_channels[i].name.c_str();
-    chObj["units"] = adc1_channels[i].units.c_str();
-    chObj["mode"] = adc1_channels[i].mode.c_str();
-    JsonArray inArr = chObj["inputs"].to<JsonArray>();
-    for (int v : adc1_channels[i].inputs) inArr.add(v);
-    chObj["scale_factor"] = adc1_channels[i].scale_factor;
-    JsonObject tbObj = chObj["tare_bias"].to<JsonObject>();
-    if (adc1_channels[i].tare_bias.auto_tare) {
-      tbObj["auto"] = true;
-    } else {
-      tbObj["value"] = adc1_channels[i].tare_bias.value;
-    }
-  }
-  // adc2
+  for (int i = 0; i < 4; ++i) writeChannel(chArr1.add<JsonObject>(), adc1_channels[i]);
   JsonArray chArr2 = doc["adc2"]["channels"].to<JsonArray>();
-  for (int i = 0; i < 4; ++i) {
-    JsonObject chObj = chArr2.add<JsonObject>();
-    chObj["name"] = adc2_channels[i].name.c_str();
-    chObj["units"] = adc2_channels[i].units.c_str();
-    chObj["mode"] = adc2_channels[i].mode.c_str();
-    JsonArray inArr = chObj["inputs"].to<JsonArray>();
-    for (int v : adc2_channels[i].inputs) inArr.add(v);
-    chObj["scale_factor"] = adc2_channels[i].scale_factor;
-    JsonObject tbObj = chObj["tare_bias"].to<JsonObject>();
-    if (adc2_channels[i].tare_bias.auto_tare) {
-      tbObj["auto"] = true;
-    } else {
-      tbObj["value"] = adc2_channels[i].tare_bias.value;
-    }
-  }
+  for (int i = 0; i < 4; ++i) writeChannel(chArr2.add<JsonObject>(), adc2_channels[i]);
   doc["rf_frequency"] = rf_frequency;
   doc["sampling_rate"] = sampling_rate;
   doc["mode"] = mode;
+  JsonObject burstObj = doc["burst"].to<JsonObject>();
+  burstObj["pre_trigger_s"] = burst.pre_trigger_s;
+  burstObj["post_trigger_s"] = burst.post_trigger_s;
+  burstObj["threshold_channel"] = burst.threshold_channel;
+  burstObj["threshold"] = burst.threshold;
+  JsonObject burnObj = doc["burn"].to<JsonObject>();
+  burnObj["thrust_channel"] = burn.thrust_channel.c_str();
+  burnObj["pressure_channel"] = burn.pressure_channel.c_str();
+  burnObj["thrust_threshold"] = burn.thrust_threshold;
+  JsonObject adaptiveObj = doc["adaptive_log"].to<JsonObject>();
+  adaptiveObj["enabled"] = adaptive_log.enabled;
+  adaptiveObj["idle_hz"] = adaptive_log.idle_hz;
+  adaptiveObj["pre_roll_s"] = adaptive_log.pre_roll_s;
+  adaptiveObj["hold_s"] = adaptive_log.hold_s;
+  JsonArray derivedArr = doc["derived"].to<JsonArray>();
+  for (const DerivedConfig& d : derived) {
+    JsonObject dObj = derivedArr.add<JsonObject>();
+    dObj["name"] = d.name.c_str();
+    dObj["units"] = d.units.c_str();
+    dObj["expr"] = d.expr.c_str();
+  }
   serializeJsonPretty(doc, file);
   file.close();
   return true;
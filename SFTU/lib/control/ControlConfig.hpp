@@ -4,7 +4,9 @@
 #include <stdint.h>
 
 #include <array>
+#include <cmath>
 #include <string>
+#include <utility>
 #include <vector>
 
 class SD_Talker;
@@ -14,14 +16,82 @@ struct TareBias {
   float value = 0.0f;
 };
 
+// One stage of a channel's filter chain. type is "notch", "lowpass" or "moving_average"
+struct FilterConfig {
+  std::string type;
+  float freq_hz = 0.0f;  // notch centre or low-pass corner
+  float q = 0.7071f;
+  int length = 1;  // moving average window in samples
+};
+
+// Multi-point or polynomial calibration, used instead of scale_factor when set. Volts are after the tare offset
+struct CalibrationConfig {
+  std::vector<std::pair<float, float>> points;  // (volts, units), 2 to 16 of them, compiled into a lookup table
+  std::vector<float> polynomial;                // c0 + c1 * v + c2 * v^2 ..., only used without points
+};
+
+// Where a channel has to stay for adaptive logging to count it as quiet, in its units and units/s.
+// Bounds left out of the config don't apply
+struct QuietBand {
+  bool enabled = false;  // the channel has a "quiet" band, channels without one never hold the full rate
+  float min = -INFINITY;
+  float max = INFINITY;
+  float rate = INFINITY;  // largest |change| per second between samples
+};
+
 struct ChannelConfig {
   std::string name;
   std::string units;
   std::string mode;
   std::vector<int> inputs;
   float scale_factor = 1.0f;
+  float sample_rate = 0.0f;  // Target rate in Hz, 0 = every acquisition tick
+  int oversample = 1;        // conversions summed into each logged sample, converted at sample_rate * oversample
+  bool auto_gain = false;    // pick the PGA gain from the signal level instead of the ADC-wide +/-4.096 V
   TareBias tare_bias;
+  CalibrationConfig calibration;
+  std::vector<FilterConfig> filters;  // applied in order after scaling
+  QuietBand quiet;
   int mux = -1;
+
+  // Everything but the labels matches, so a reload can leave the channel's processor alone
+  bool sameSignal(const ChannelConfig& other) const;
+  // Logged as 32 bit counts with COUNT_FRACTION_BITS: sums of conversions, auto-ranged counts and
+  // filter output don't fit 16 bits. Plain channels log whole ADS1115 counts
+  bool wideCounts() const { return oversample > 1 || auto_gain || !filters.empty(); }
+};
+
+// Pre/post trigger capture around sequence starts, E-stops and an optional threshold
+struct BurstConfig {
+  float pre_trigger_s = 5.0f;
+  float post_trigger_s = 5.0f;
+  int threshold_channel = -1;  // 1-8, -1 = no threshold trigger
+  float threshold = 0.0f;      // in the channel's units, triggers when the value rises above it
+};
+
+// Burn summary sent when a sequence ends. Channels are "CH1"-"CH8" or a derived "D1"-"D4", "" for none
+struct BurnConfig {
+  std::string thrust_channel = "CH1";
+  std::string pressure_channel = "CH6";
+  float thrust_threshold = 50.0f;  // in the thrust channel's units, burning while above it
+};
+
+// Log at idle_hz while every channel with a quiet band is inside it and no sequence is running.
+// Full rate resumes the moment one leaves its band or a sequence starts, with pre_roll_s of full rate
+// records kept ahead of it, and carries on for hold_s after the last excursion
+struct AdaptiveLogConfig {
+  bool enabled = false;
+  float idle_hz = 1.0f;
+  float pre_roll_s = 1.0f;
+  float hold_s = 5.0f;
+};
+
+// Channel computed from the others each sample, e.g. "CH1 + CH2 + CH3" or "integral(D1)".
+// See DerivedChannels for the expression syntax
+struct DerivedConfig {
+  std::string name;
+  std::string units;
+  std::string expr;
 };
 
 class ControlConfig {
@@ -38,6 +108,7 @@ class ControlConfig {
       ch.mode = "differential";
       ch.inputs = {0, 1};
       ch.scale_factor = 1494.0f;
+      ch.sample_rate = 250.0f;
       ch.tare_bias.auto_tare = true;
       ch.tare_bias.value = 0.0f;
     } else if (i == 1) {
@@ -46,6 +117,7 @@ class ControlConfig {
       ch.mode = "differential";
       ch.inputs = {2, 3};
       ch.scale_factor = 1494.0f;
+      ch.sample_rate = 250.0f;
       ch.tare_bias.auto_tare = true;
       ch.tare_bias.value = 0.0f;
     } else {
@@ -67,6 +139,7 @@ class ControlConfig {
       ch.mode = "differential";
       ch.inputs = {0, 1};
       ch.scale_factor = 1494.0f;
+      ch.sample_rate = 250.0f;
       ch.tare_bias.auto_tare = true;
       ch.tare_bias.value = 0.0f;
     } else if (i == 1) {
@@ -75,6 +148,7 @@ class ControlConfig {
       ch.mode = "single_ended";
       ch.inputs = {2};
       ch.scale_factor = 488.28f;
+      ch.sample_rate = 50.0f;
       ch.tare_bias.auto_tare = false;
       ch.tare_bias.value = 0.4096f;
     } else if (i == 2) {
@@ -83,6 +157,7 @@ class ControlConfig {
       ch.mode = "single_ended";
       ch.inputs = {3};
       ch.scale_factor = 488.28f;
+      ch.sample_rate = 50.0f;
       ch.tare_bias.auto_tare = false;
       ch.tare_bias.value = 0.4096f;
     } else {
@@ -102,6 +177,10 @@ class ControlConfig {
   uint32_t rf_frequency;                       // RF frequency in Hz
   int sampling_rate;                           // ADC sampling rate (SPS)
   int mode;                                    // Operation mode (0=normal, 1=RF off, etc)
+  BurstConfig burst;
+  BurnConfig burn;
+  AdaptiveLogConfig adaptive_log;
+  std::vector<DerivedConfig> derived;  // up to 4, logged and sent after the physical channels
 
   ControlConfig();
 
@@ -1,6 +1,8 @@
 
 #include "control.hpp"
 
+constexpr adsGain_t Control::AUTO_GAINS[];
+
 Control::Control() {
   m_ANALOG_I2C_BUS = new TwoWire(0);
   m_I2C_BUS = new TwoWire(1);
@@ -24,15 +26,21 @@ Control::Control() {
 
 #ifdef SFTU
   m_actuation = new Actuation(PCA6408A_SLAVE_ADDRESS_L, PCA6408A_SLAVE_ADDRESS_H, *m_I2C_BUS);
-  m_commander = new Commander(m_serialCom, m_LoRaCom, m_actuation, m_adcADS_12, m_adcProcessors);  // TODO: Probably want control of both ADCs in Commander
+  m_sampleClock = new SampleClock();
+  m_burstCapture = new BurstCapture();
+  m_converter = new ChannelConverter(m_adcProcessors, m_lsbV);
+  m_calCapture = new CalibrationCapture(m_adcProcessors, m_lsbV);
+  m_spectrum = new SpectrumAnalyzer(m_adcProcessors, m_lsbV);
+  m_planner = new AcquisitionPlanner();
+  m_configReload = new ConfigReload();
+  m_burnMonitor = new BurnMonitor();
+  m_commander = new Commander(m_serialCom, m_LoRaCom, m_actuation, m_adcADS_12, m_adcProcessors, m_sampleClock, m_burstCapture, m_calCapture, m_spectrum, m_planner, m_configReload, m_burnMonitor);  // TODO: Probably want control of both ADCs in Commander
 
   m_display = new Display();
 #else
   m_commander = new Commander(m_serialCom, m_LoRaCom);
   m_saveFlash = new SaveFlash(m_serialCom);
 #endif
-
-  m_latestSampleMutex = xSemaphoreCreateMutex();
 }
 
 void Control::setup() {
@@ -63,14 +71,19 @@ void Control::setup() {
     ESP_LOGI(TAG, "Loaded config from SD");
   }
 
+  // The sample layout needs to know which channels are in use before any task starts
+  m_setup.store(ChannelSetup::build(*m_config, 0, SAMPLE_RING_SIZE), std::memory_order_release);
+
   m_adcADS_12->init(ADS0_ADDR);  // Use ADS0 address
   m_adcADS_34->init(ADS1_ADDR);  // Use ADS1 address
+  m_adcADS_12->enableReadyInterrupt(ADS0_RDY, NOTIFY_ADS0_RDY);
+  m_adcADS_34->enableReadyInterrupt(ADS1_RDY, NOTIFY_ADS1_RDY);
+  m_adcADS_12->setTimedRead(ADS0_RDY < 0);  // Without ALERT/RDY wired, timing out the conversion beats polling the bus
+  m_adcADS_34->setTimedRead(ADS1_RDY < 0);
   m_battMonitor->init();         // Initialize battery monitor
 
   m_display->init(*m_I2C_BUS);  // Initialize the display
 
-  // from testing, queue goes up to ~200 samples during sd write
-  m_adcQueue = xQueueCreate(512, sizeof(SampleWithTimestamp));
 
 #else
 #endif
@@ -151,7 +164,7 @@ void Control::begin() {
 
   xTaskCreate([](void *param) { static_cast<Control *>(param)->sdTask(); }, "sdTask", 8192, this, 3, &m_taskHandles.sdTaskHandle);
 
-  xTaskCreate([](void *param) { static_cast<Control *>(param)->displayTask(); }, "displayTask", 4096, this, 1, &m_taskHandles.displayTaskHandle);
+  xTaskCreate([](void *param) { static_cast<Control *>(param)->displayTask(); }, "displayTask", 6144, this, 1, &m_taskHandles.displayTaskHandle);
 
   ESP_LOGI(TAG, "Control begun!\n");
 
@@ -171,15 +184,15 @@ void Control::displayTask() {
   // m_display->dim(true);
   m_display->begin();  // Begin the display
 
+  ChannelConverter converter(m_adcProcessors, m_lsbV);
+
   while (true) {
     // Update the display with the current force value
-    // if (m_adcQueue != nullptr) {
-    //   if (xQueuePeek(m_adcQueue, &sample, pdMS_TO_TICKS(50))) {
-    //   }
-    // }
     SampleWithTimestamp sample;
+    float units[8];
     getLatestSample(sample);  // Get the latest sample from the queue
-    m_display->drawData(sample.value1, sample.value2, sample.value3, sample.value4, sample.value5, sample.value6, sample.value7, sample.value8, true);
+    converter.convert(sample.counts, units, sample.channelMask);
+    m_display->drawData(units[0], units[1], units[2], units[3], units[4], units[5], units[6], units[7], true);
     vTaskDelay(pdMS_TO_TICKS(40));
   }
 }
@@ -188,8 +201,6 @@ void Control::analogTask() {
   m_adcADS_12->setInputConfig(GAIN_ONE, RATE_ADS1115_860SPS);
   m_adcADS_34->setInputConfig(GAIN_ONE, RATE_ADS1115_860SPS);
 
-  uint64_t interval_us = (uint64_t)(1e6 / (double)ADC_SPS);
-
   // Set up load cell processing
   // float averageSample = m_adcADS_12->getAverageVolt(200, ADS1X15_REG_CONFIG_MUX_DIFF_0_1);
   // m_loadCell1->tareVolts(averageSample);
@@ -201,121 +212,538 @@ void Control::analogTask() {
 
   vTaskDelay(pdMS_TO_TICKS(100));
   setupADC_Config();
+  setupBurstCapture();
+  m_spectrum->begin();
+  m_converter->benchmark(1000);
+
+  // Paced by the hardware timer. Fall back to the tick-based delay if it can't be started
+  bool clockRunning = m_sampleClock->begin(m_tickRateHz, xTaskGetCurrentTaskHandle(), NOTIFY_SAMPLE_CLOCK);
+  uint64_t interval_us = (uint64_t)(1e6 / (double)m_tickRateHz);
+  m_scanStats.windowStartUs = micros();
 
   uint64_t lastMicros = 0;
+  unsigned long lastStatsMillis = millis();
 
   while (true) {
-    if (!m_pauseADC) {
-      lastMicros = micros();
-      queueSample();
-
-      // print adc2 readings to test
-      // ESP_LOGD(TAG, "ADC2 MUX 0: %f V", m_adcADS_34->readNewVolt(ADS1X15_REG_CONFIG_MUX_DIFF_0_1));
+    if (clockRunning) {
+      m_sampleClock->waitForTick();
+    } else {
+      vTaskDelay(pdMS_TO_TICKS(1));  // can't starve other tasks
+      while ((micros() - lastMicros) < interval_us) {
+        vTaskDelay(pdMS_TO_TICKS(1));
+      }
+    }
+    m_sampleClock->markSample();
+
+    lastMicros = micros();
+    queueSample();
+
+    // Run every channel as fast as the ADCs allow for the post-trigger window only, and take up any
+    // new plan from the commander between scans
+    bool wantBurstRate = m_burstCapture->state() == BurstCapture::State::POST_TRIGGER;
+    AcquisitionPlan plan;
+    bool replan = m_planner->takeRequest(plan);
+    if (replan) m_plan = plan;
+
+    // Likewise a reloaded config, which brings its own plan. Not while a burst is being captured, the
+    // window would end up with records of two layouts
+    BurstCapture::State burstState = m_burstCapture->state();
+    if (m_nextSetup.load(std::memory_order_acquire) != nullptr && burstState != BurstCapture::State::POST_TRIGGER && burstState != BurstCapture::State::FROZEN) {
+      applySetup(m_nextSetup.exchange(nullptr, std::memory_order_acq_rel));
+      replan = true;
+    }
+    if (replan || wantBurstRate != m_burstRate) {
+      // The timing stats run on across the switch, a snapshot here splits them into before and after
+      if (clockRunning && wantBurstRate != m_burstRate) {
+        char timing[200];
+        m_sampleClock->formatStats(timing, sizeof(timing));
+        ESP_LOGI(TAG, "Leaving the %s tick rate, %s", m_burstRate ? "burst" : "normal", timing);
+      }
+      m_burstRate = wantBurstRate;
+      buildSchedule(m_burstRate);
+      if (clockRunning) m_sampleClock->setRate(m_tickRateHz);
+      interval_us = (uint64_t)(1e6 / (double)m_tickRateHz);
+    }
+    if (replan) {
+      // The pre-trigger window is sized from the tick rate. A capture already under way keeps its buffer
+      if (m_burstCapture->state() == BurstCapture::State::ARMED) setupBurstCapture();
+      m_planner->setActive(m_plan);
     }
 
-    vTaskDelay(pdMS_TO_TICKS(1));  // can't starve other tasks
-    while ((micros() - lastMicros) < interval_us) {
-      // ESP_LOGD(TAG, "Waiting in analogtask");
-      vTaskDelay(pdMS_TO_TICKS(1));
+    if (millis() - lastStatsMillis >= acquisitionStats_Interval) {
+      logAcquisitionStats();
+      lastStatsMillis = millis();
     }
+
+    // print adc2 readings to test
+    // ESP_LOGD(TAG, "ADC2 MUX 0: %f V", m_adcADS_34->readNewVolt(ADS1X15_REG_CONFIG_MUX_DIFF_0_1));
   }
 }
 
 void Control::queueSample() {
   SampleWithTimestamp sample;
-  static uint64_t startMicros = micros();
-  sample.timestamp = micros() - startMicros;
+  static uint64_t startMicros = esp_timer_get_time();
+  uint32_t scanStartMicros = micros();
+  // 64-bit so long burns don't wrap after ~71 minutes like micros() does
+  sample.timestamp = esp_timer_get_time() - startMicros;
 
   adcADS *adcs[2] = {m_adcADS_12, m_adcADS_34};
-  std::array<std::array<ChannelConfig, 4> *, 2> configs = {&m_config->adc1_channels, &m_config->adc2_channels};
+  ChannelSetup &setup = *m_setup.load(std::memory_order_relaxed);
+  std::array<const std::array<ChannelConfig, 4> *, 2> configs = {&setup.config.adc1_channels, &setup.config.adc2_channels};
+
+  // Raw counts all the way to the consumers, units are only worked out where they're needed
+  memset(sample.counts, 0, sizeof(sample.counts));
+  sample.channelMask = 0;
+  memset(sample.channelOffsetUs, 0, sizeof(sample.channelOffsetUs));
+
+  // Collect the channels due on this tick, per ADC
+  int8_t due[2][4];
+  size_t numDue[2] = {0, 0};
+  for (int idx = 0; idx < 8; ++idx) {
+    ChannelSchedule &sched = m_schedule[idx];
+    if (sched.active && (m_tick % sched.divider) == sched.phase) due[idx / 4][numDue[idx / 4]++] = idx;
+  }
+  m_tick++;
+
+  // Both ADCs convert at once, so each step costs one conversion time instead of two
+  size_t numSteps = std::max(numDue[0], numDue[1]);
+  for (size_t s = 0; s < numSteps; ++s) {
+    ScanStep step;
+    step.channel[0] = (s < numDue[0]) ? due[0][s] : -1;
+    step.channel[1] = (s < numDue[1]) ? due[1][s] : -1;
+
+    bool started[2] = {false, false};
+    for (int adcIdx = 0; adcIdx < 2; ++adcIdx) {
+      int idx = step.channel[adcIdx];
+      if (idx < 0) continue;
+      const ChannelSchedule &sched = m_schedule[idx];
+      uint16_t mux = (*configs[adcIdx])[idx % 4].mux;
+      started[adcIdx] = sched.autoGain ? adcs[adcIdx]->startConversion(mux, AUTO_GAINS[sched.gainLevel]) : adcs[adcIdx]->startConversion(mux);
+    }
+    for (int adcIdx = 0; adcIdx < 2; ++adcIdx) {
+      if (!started[adcIdx]) continue;
+      int idx = step.channel[adcIdx];
+      ChannelSchedule &sched = m_schedule[idx];
+      int32_t raw = adcs[adcIdx]->finishConversion();
+      if (sched.autoGain) raw = autoRange(idx, raw);
+      if (sched.pending > 0) {
+        float diff = (float)(raw - sched.lastRaw);
+        sched.rawDiffSq += diff * diff;
+        sched.rawDiffs++;
+      }
+      sched.lastRaw = raw;
+      sched.sum += raw;
+      uint16_t conversions = sched.oversample * sched.decimation;
+      if (++sched.pending < conversions) continue;
+
+      // The sum keeps log2(oversample) extra bits, the converter's LSB is divided down to match. Its
+      // timestamp is the last conversion, the average sits (conversions - 1) / 2 conversions earlier
+      if (conversions > 1) {
+        if (sched.haveSum) {
+          float diff = (float)(sched.sum - sched.lastSum) / conversions;
+          sched.sumDiffSq += diff * diff;
+          sched.sumDiffs++;
+        }
+        sched.lastSum = sched.sum;
+        sched.haveSum = true;
+      }
+      // Decimating averages the sum down to the oversampled scale. Dividing after the shift keeps what
+      // the average gains in the fraction bits of 32 bit channels instead of rounding it off to whole counts
+      int64_t scaled = (int64_t)sched.sum * (1 << m_fractionBits[idx]);
+      int64_t half = sched.decimation / 2;
+      sample.counts[idx] = (int32_t)((scaled >= 0) ? (scaled + half) / sched.decimation : -((-scaled + half) / sched.decimation));
+      sample.channelMask |= (1 << idx);
+      sched.samples++;
+      sched.sum = 0;
+      sched.pending = 0;
+
+      // Scans take a few ms at most, well inside 16 bits of us
+      uint32_t offsetUs = adcs[adcIdx]->lastConversionUs() - scanStartMicros;
+      sample.channelOffsetUs[idx] = (uint16_t)std::min<uint32_t>(offsetUs, UINT16_MAX);
+    }
+  }
 
-  float *sampleValues[9] = {&sample.value1, &sample.value2, &sample.value3, &sample.value4, &sample.value5, &sample.value6, &sample.value7, &sample.value8, &sample.battery_voltage};
+  uint32_t scanUs = micros() - scanStartMicros;
+  m_scanStats.count++;
+  m_scanStats.totalUs += scanUs;
+  if (scanUs < m_scanStats.minUs) m_scanStats.minUs = scanUs;
+  if (scanUs > m_scanStats.maxUs) m_scanStats.maxUs = scanUs;
+
+  // Tare from the raw counts, ahead of the filters' start-up transient. Rows logged until every
+  // auto-tare channel has its offset are flagged
+  if (m_autoTare.pending()) {
+    uint8_t tared = m_autoTare.feed(sample.counts, sample.channelMask);
+    for (int idx = 0; idx < 8; ++idx) {
+      if (!(tared & (1 << idx))) continue;
+      m_adcProcessors[idx]->tareVolts(m_autoTare.mean(idx) * m_lsbV[idx]);
+      ESP_LOGI(TAG, "CH%d auto-tare %.6f V, sd %.2f counts over %u samples", idx + 1, m_autoTare.mean(idx) * m_lsbV[idx], m_autoTare.stddev(idx) / (1 << m_fractionBits[idx]), AUTO_TARE_SAMPLES);
+    }
+    // Integrals over the untared values would carry the offset for the rest of the run
+    if (tared) m_derived.reset();
+  }
+  sample.flags = m_autoTare.pending() ? RECORD_FLAG_PRE_TARE : 0;
+
+  // Filters have unity DC gain and the count to unit mapping is affine, so filtering counts is the
+  // same as filtering units. Filtered channels are 32 bit, rounding keeps COUNT_FRACTION_BITS below the LSB
+  for (int idx = 0; idx < 8; ++idx) {
+    FilterChain &chain = m_adcProcessors[idx]->filters();
+    if ((sample.channelMask & (1 << idx)) && chain.numStages()) {
+      float filtered = chain.process((float)sample.counts[idx]);
+      sample.counts[idx] = (int32_t)lroundf(filtered);
+    }
+  }
 
-  for (int adcIdx = 0; adcIdx < 2; ++adcIdx) {
-    for (int ch = 0; ch < 4; ++ch) {
-      int idx = adcIdx * 4 + ch;
-      ChannelConfig &cfg = (*configs[adcIdx])[ch];
-      if (cfg.mux != -1) {
-        float raw = adcs[adcIdx]->readNewVolt(cfg.mux);
-        *sampleValues[idx] = m_adcProcessors[idx]->processVtoUnits(raw);
-      } else {
-        *sampleValues[idx] = 0.0f;
-      }
+  // Status windows and derived channels work in units after the filters
+  float units[8];
+  if (sample.channelMask) m_converter->convert(sample.counts, units, sample.channelMask);
+  m_windowStats.add(sample.timestamp, units, sample.channelMask);
+
+  // Channels not due on this tick contribute their last value to derived channels, and integrals
+  // and derivatives step over the time since the last evaluation
+  memset(sample.derived, 0, sizeof(sample.derived));
+  if (m_derived.size() && sample.channelMask) {
+    for (int idx = 0; idx < 8; ++idx) {
+      if (sample.channelMask & (1 << idx)) m_derivedInputs[idx] = units[idx];
+    }
+    float dtS = m_derivedLastUs ? (sample.timestamp - m_derivedLastUs) / 1e6f : 0.0f;
+    m_derivedLastUs = sample.timestamp;
+    m_derived.evaluate(m_derivedInputs, dtS, sample.derived);
+  }
+
+  // Burn tracking runs every sample so sequence starts and ends are picked up, untared thrust is left out
+  auto burnInput = [&](int8_t ref, float &value) {
+    if (ref < 0 || (sample.flags & RECORD_FLAG_PRE_TARE)) return false;
+    if (ref < 8) {
+      if (!(sample.channelMask & (1 << ref))) return false;
+      value = units[ref];
+      return true;
+    }
+    value = sample.derived[ref - 8];
+    return sample.channelMask != 0;
+  };
+  float thrust = 0.0f, pressure = 0.0f;
+  bool haveThrust = burnInput(m_burnThrust, thrust);
+  bool havePressure = burnInput(m_burnPressure, pressure);
+  m_burnMonitor->feed(sample.timestamp, haveThrust, thrust, havePressure, pressure);
+
+  // Records flagged quiet may be thinned out by the SD task. Sequences and untared rows always go in full
+  if (m_adaptiveLog) {
+    bool busy = m_burnMonitor->tracking() || (sample.flags & RECORD_FLAG_PRE_TARE);
+    bool quiet = m_quietDetector.quiet(sample.timestamp, units, sample.channelMask, busy);
+    if (quiet) sample.flags |= RECORD_FLAG_QUIET;
+    if (quiet != m_loggingQuiet) {
+      ESP_LOGI(TAG, "Logging at %s", quiet ? "the idle rate" : "full rate");
+      m_loggingQuiet = quiet;
     }
   }
 
-  *sampleValues[8] = m_battMonitor->getScaledVoltage(1);  // Read battery voltage
+  sample.battery_voltage = m_battMonitor->getScaledVoltage(1);  // Read battery voltage
 
   setLatestSample(sample);
+  m_calCapture->feed(sample.counts, sample.channelMask);
+  m_spectrum->feed(sample.timestamp, sample.counts, sample.channelMask);
+
+  const BurstConfig &burst = setup.config.burst;
+  int thresholdIdx = burst.threshold_channel - 1;
+  if (thresholdIdx >= 0 && thresholdIdx < 8 && !(sample.flags & RECORD_FLAG_PRE_TARE) && (sample.channelMask & (1 << thresholdIdx)) && m_converter->toUnits(thresholdIdx, sample.counts[thresholdIdx]) > burst.threshold) {
+    m_burstCapture->trigger(BurstTrigger::THRESHOLD);
+  }
+
+  // Nothing to log while every oversampled channel is still summing
+  if (sample.channelMask == 0) return;
+
+  // Pack the active channels straight into the ring. Dropped (and counted) if the SD task has fallen a full ring behind
+  uint8_t *record = setup.ring.reserve();
+  if (record != nullptr) {
+    packSample(sample, setup.layout, record);
+    setup.ring.commit();
+  }
 
-  if (xQueueSend(m_adcQueue, &sample, 0) != pdPASS) {
-    SampleWithTimestamp dummy;
-    xQueueReceive(m_adcQueue, &dummy, 0);
-    xQueueSend(m_adcQueue, &sample, 0);
+  uint8_t *burstRecord = m_burstCapture->slot();
+  if (burstRecord != nullptr) {
+    packSample(sample, setup.layout, burstRecord);
+    m_burstCapture->commit(sample.timestamp);
   }
 }
 
+int32_t Control::autoRange(int idx, int16_t raw) {
+  ChannelSchedule &sched = m_schedule[idx];
+  // Every level doubles the gain, so shifting lines all of them up on the top level's LSB
+  int32_t value = (int32_t)raw << (AUTO_GAIN_LEVELS - 1 - sched.gainLevel);
+
+  int32_t magnitude = abs(raw);
+  if (magnitude > sched.gainWindowPeak) sched.gainWindowPeak = magnitude;
+
+  uint8_t level = sched.gainLevel;
+  if (magnitude >= AUTO_GAIN_UP && level > 0) {
+    level--;
+  } else if (++sched.gainWindowCount >= AUTO_GAIN_WINDOW) {
+    if (sched.gainWindowPeak < AUTO_GAIN_DOWN && level < AUTO_GAIN_LEVELS - 1) level++;
+    sched.gainWindowPeak = 0;
+    sched.gainWindowCount = 0;
+  }
+
+  if (level != sched.gainLevel) {
+    ESP_LOGI(TAG, "CH%d gain %s to +/-%.3f V", idx + 1, level > sched.gainLevel ? "up" : "down", adcADS::lsbForGain(AUTO_GAINS[level]) * 32768.0f);
+    sched.gainLevel = level;
+    sched.gainWindowPeak = 0;
+    sched.gainWindowCount = 0;
+    sched.gainSwitches++;
+  }
+  return value;
+}
+
+void Control::packSample(const SampleWithTimestamp &sample, const SampleLayout &layout, uint8_t *record) const {
+  SampleRecordHeader *header = reinterpret_cast<SampleRecordHeader *>(record);
+  uint16_t *offsetsUs = layout.offsetsUs(record);
+  header->timestamp = sample.timestamp;
+  header->battery_voltage = sample.battery_voltage;
+  header->slotMask = 0;
+  header->flags = sample.flags;
+  memcpy(layout.derived(record), sample.derived, layout.numDerived * sizeof(float));
+  for (int slot = 0; slot < layout.numChannels; ++slot) {
+    int idx = layout.channel[slot];
+    layout.setCount(record, slot, sample.counts[idx]);
+    offsetsUs[slot] = sample.channelOffsetUs[idx];
+    if (sample.channelMask & (1 << idx)) header->slotMask |= (1 << slot);
+  }
+}
+
+void Control::logAcquisitionStats() {
+  adcADS *adcs[2] = {m_adcADS_12, m_adcADS_34};
+  for (int adcIdx = 0; adcIdx < 2; ++adcIdx) {
+    ConversionStats stats = adcs[adcIdx]->getConversionStats();
+    if (stats.count == 0) continue;
+    ESP_LOGD(TAG, "ADC%d conversions: %u, latency avg %llu us, max %u us, RDY timeouts %u, I2C transactions/sample %.2f", adcIdx + 1, stats.count, (unsigned long long)(stats.totalUs / stats.count), stats.maxUs, stats.rdyTimeouts, (float)stats.i2cTransactions / stats.count);
+    adcs[adcIdx]->resetConversionStats();
+  }
+
+  uint32_t nowUs = micros();
+  float windowS = (nowUs - m_scanStats.windowStartUs) / 1e6f;
+  if (m_scanStats.count > 0 && windowS > 0.0f) {
+    uint32_t avgUs = m_scanStats.totalUs / m_scanStats.count;
+    ESP_LOGI(TAG, "Scan period avg %u us (min %u, max %u) over %u scans", avgUs, m_scanStats.minUs, m_scanStats.maxUs, m_scanStats.count);
+
+    SpscRing &ring = m_setup.load(std::memory_order_relaxed)->ring;
+    ESP_LOGI(TAG, "Sample ring: high water %u/%u, dropped %u", (unsigned)ring.highWater(), (unsigned)ring.capacity(), ring.dropped());
+    ring.resetStats();
+
+    ESP_LOGI(TAG, "Latest sample: %u reads, %u torn-read retries", m_latestSample.reads(), m_latestSample.retries());
+    m_latestSample.resetStats();
+
+    // Cost of each filter stage, to see what the chain can afford at the tick rate
+    uint32_t cpuMHz = ESP.getCpuFreqMHz();
+    for (int idx = 0; idx < 8; ++idx) {
+      if (!m_adcProcessors[idx]) continue;
+      FilterChain &chain = m_adcProcessors[idx]->filters();
+      for (size_t stage = 0; stage < chain.numStages(); ++stage) {
+        FilterStageStats fs = chain.getStageStats(stage);
+        if (fs.count == 0) continue;
+        float cycles = (float)fs.cycles / fs.count;
+        ESP_LOGD(TAG, "CH%d filter %u (%s): %.0f cycles/sample (%.2f us)", idx + 1, (unsigned)stage, FilterChain::typeName(fs.type), cycles, cycles / cpuMHz);
+      }
+      chain.resetStats();
+    }
+
+    if (m_derived.evaluations() > 0) {
+      float cycles = (float)m_derived.cycles() / m_derived.evaluations();
+      ESP_LOGD(TAG, "Derived channels: %u, %.0f cycles/sample (%.2f us)", (unsigned)m_derived.size(), cycles, cycles / cpuMHz);
+      m_derived.resetStats();
+    }
+
+    JitterStats jitter = m_sampleClock->getStats();
+    ESP_LOGI(TAG, "Sample clock: period %u us, max jitter %u us, missed ticks %u", jitter.periodUs, jitter.maxJitterUs, jitter.missedTicks);
+
+    for (int idx = 0; idx < 8; ++idx) {
+      ChannelSchedule &sched = m_schedule[idx];
+      if (!sched.active) continue;
+      float achievedHz = sched.samples / windowS;
+      if (fabsf(achievedHz - sched.targetHz) > RATE_TOLERANCE * sched.targetHz) {
+        ESP_LOGW(TAG, "CH%d rate %.1f Hz, target %.1f Hz (outside %.0f%% tolerance)", idx + 1, achievedHz, sched.targetHz, RATE_TOLERANCE * 100.0f);
+      } else {
+        ESP_LOGI(TAG, "CH%d rate %.1f Hz, target %.1f Hz", idx + 1, achievedHz, sched.targetHz);
+      }
+      sched.samples = 0;
+
+      // Noise from first differences (std / sqrt(2)) before and after summing, in single conversion LSBs.
+      // Averaging white noise over N conversions should gain 0.5 * log2(N) bits; less means the noise is
+      // correlated, or too small to dither the quantiser
+      uint16_t conversions = sched.oversample * sched.decimation;
+      if (conversions > 1 && sched.rawDiffs > 0 && sched.sumDiffs > 0) {
+        float rawNoise = sqrtf(sched.rawDiffSq / sched.rawDiffs / 2.0f);
+        float sumNoise = sqrtf(sched.sumDiffSq / sched.sumDiffs / 2.0f);
+        float gained = (sumNoise > 0.0f && rawNoise > 0.0f) ? log2f(rawNoise / sumNoise) : 0.0f;
+        ESP_LOGI(TAG, "CH%d oversample x%u: raw noise %.2f LSB, decimated %.3f LSB, %.1f bits gained (theory %.1f)", idx + 1, conversions, rawNoise, sumNoise, gained, 0.5f * log2f((float)conversions));
+      }
+      if (sched.autoGain) {
+        ESP_LOGI(TAG, "CH%d gain +/-%.3f V, %u switches", idx + 1, adcADS::lsbForGain(AUTO_GAINS[sched.gainLevel]) * 32768.0f, sched.gainSwitches);
+        sched.gainSwitches = 0;
+      }
+
+      sched.rawDiffSq = sched.sumDiffSq = 0.0f;
+      sched.rawDiffs = sched.sumDiffs = 0;
+      sched.haveSum = false;
+    }
+  }
+  m_scanStats = ScanStats();
+  m_scanStats.windowStartUs = nowUs;
+}
+
 void Control::sdTask() {
   pinMode(INDICATOR_LED3, OUTPUT);
-  constexpr size_t blockSize = 512;
-  static SampleWithTimestamp block[blockSize];
 
-  size_t count = 0;
+  // Largest span handed to a single SD write
+  constexpr size_t maxBlockSize = 512;
 
-  // Max wait before flushing
+  // Max wait before flushing a partial block
   const TickType_t blockTimeout = pdMS_TO_TICKS(1000);
 
-  TickType_t lastBlockTime = xTaskGetTickCount();
+  // The setup whose ring is being written out. It trails the analog task's across a reload until
+  // everything recorded before the swap is on the card
+  ChannelSetup *segment = m_setup.load(std::memory_order_acquire);
+  ChannelSetup *incoming = nullptr;  // built from a reloaded config, not yet being logged
+  TickType_t liveSince = xTaskGetTickCount();  // when `segment` took over from the one before
+  segment->ring.setConsumer(xTaskGetCurrentTaskHandle(), SD_WATERMARK);
 
-  // Convert std::vector<std::string> to std::vector<String> for SD_Talker
-  std::vector<std::string> stdNames = m_config->getChannelNames();
-  std::vector<std::string> stdUnits = m_config->getChannelUnits();
+  // Records carry raw counts, units are worked out here as they're formatted
+  ChannelConverter converter(m_adcProcessors, m_lsbV);
+  SampleLayout sdLayout = segment->layout;
 
-  std::vector<String> newStdNames, newStdUnits;
-  newStdNames.reserve(stdNames.size() + 1);  // +1 for battery voltage
-  newStdUnits.reserve(stdUnits.size() + 1);  // +1 for battery voltage
-  for (const auto &n : stdNames) newStdNames.push_back(String(n.c_str()));
-  for (const auto &u : stdUnits) newStdUnits.push_back(String(u.c_str()));
+  std::vector<String> names, units;
+  segment->columns(names, units);
 
-  // Add battery voltage column
-  newStdNames.push_back(String("Battery Voltage"));
-  newStdUnits.push_back(String("V"));
+  // Quiet records are thinned out before they reach the card when the segment's config asks for it
+  LogDecimator decimator;
+  uint8_t keep[maxBlockSize];
+  decimator.configure(segment->config.adaptive_log.idle_hz, segment->config.adaptive_log.pre_roll_s);
 
   while (true) {
     while (!m_sdTalker->checkFileOpen()) {
-      m_sdTalker->startNewLog("/Logs/log", newStdNames, newStdUnits);
+      m_sdTalker->startNewLog("/Logs/log", names, units);
       vTaskDelay(pdMS_TO_TICKS(500));
     }
 
-    // print size of queue
-    // ESP_LOGD(TAG, "Queue size: %d", uxQueueMessagesWaiting(m_adcQueue));
-
-    if (xQueueReceive(m_adcQueue, &block[count], blockTimeout)) {
-      count++;
-      // Try to fill the block as much as possible, but don't block
-      while (count < blockSize && xQueueReceive(m_adcQueue, &block[count], 0)) {
-        count++;
+    // Sleep until the analog task passes the watermark, or flush whatever is there on timeout
+    ulTaskNotifyTake(pdTRUE, blockTimeout);
+
+    // Write straight out of the ring, at most two spans per pass when it has wrapped
+    const uint8_t *span = nullptr;
+    size_t count;
+    while ((count = segment->ring.peek(&span)) > 0) {
+      count = std::min(count, maxBlockSize);
+      // Pick up any tare or scale change. Once the setup is retired the processors belong to the next
+      // one, so what's left converts as it was at the swap
+      bool retired = segment->retired.load(std::memory_order_acquire);
+      if (!retired) {
+        converter.describe(sdLayout);
+        retired = segment->retired.load(std::memory_order_acquire);
       }
-    }
-
-    // Write if block is full or timeout has passed and we have data
-    TickType_t now = xTaskGetTickCount();
-    if (count >= blockSize || (count > 0 && (now - lastBlockTime) >= blockTimeout)) {
-      // Write both value and timestamp to SD (update SD_Talker as needed)
-      bool blockWritten = m_sdTalker->writeBlockToSD(block, count);
+      const SampleLayout &layout = retired ? segment->finalLayout : sdLayout;
+      bool blockWritten = true;
+      size_t settled = count;
+      if (segment->config.adaptive_log.enabled) {
+        // Runs of kept records go out as they lie in the ring. Nothing more arrives once the setup is retired
+        settled = decimator.select(segment->ring, count, retired, keep);
+        for (size_t start = 0; start < settled && blockWritten;) {
+          if (!keep[start]) {
+            start++;
+            continue;
+          }
+          size_t end = start + 1;
+          while (end < settled && keep[end]) end++;
+          blockWritten = m_sdTalker->writeBlockToSD(span + start * layout.recordSize, end - start, layout);
+          start = end;
+        }
+      } else {
+        blockWritten = m_sdTalker->writeBlockToSD(span, count, layout);
+      }
+      segment->ring.release(settled);
       if (blockWritten) {
-        // ESP_LOGI(TAG, "Wrote %zu samples to SD", count);
         digitalWrite(INDICATOR_LED3, !digitalRead(INDICATOR_LED3));
       } else {
         digitalWrite(INDICATOR_LED3, LOW);
+        break;
+      }
+      // The rest is waiting for its pre-roll
+      if (settled < count) break;
+    }
+
+    // The analog task stops writing a setup's ring before it retires it, so once that ring is empty
+    // the old segment is complete and the new channels get a log of their own
+    if (incoming != nullptr && segment->retired.load(std::memory_order_acquire) && segment->ring.size() == 0) {
+      segment->ring.end();
+      delete m_retiredSetup;  // retired a whole reload and at least RELOAD_HOLDOFF_MS ago, no task can still hold it
+      m_retiredSetup = segment;
+      segment = incoming;
+      incoming = nullptr;
+      liveSince = xTaskGetTickCount();
+
+      sdLayout = segment->layout;
+      segment->columns(names, units);
+      decimator.configure(segment->config.adaptive_log.idle_hz, segment->config.adaptive_log.pre_roll_s);
+      m_sdTalker->closeFile();
+
+      char text[MAX_PAYLOAD_SIZE];
+      snprintf(text, sizeof(text), "config: reload %u live, %u channels, %u derived, new log started", (unsigned)segment->id, segment->layout.numChannels, segment->layout.numDerived);
+      m_configReload->report(text);
+    }
+
+    if (m_configReload->take()) {
+      if (incoming != nullptr) {
+        m_configReload->report("config: a reload is already in progress");
+      } else if (xTaskGetTickCount() - liveSince < pdMS_TO_TICKS(RELOAD_HOLDOFF_MS)) {
+        m_configReload->report("config: the last reload only just went live, try again in a moment");
+      } else {
+        incoming = reloadConfig();
       }
-      count = 0;
-      lastBlockTime = now;
     }
-    vTaskDelay(pdMS_TO_TICKS(5));
+
+    if (m_burstCapture->state() == BurstCapture::State::FROZEN) dumpBurst(converter);
   }
 }
 
+ChannelSetup *Control::reloadConfig() {
+  ControlConfig config;
+  if (!config.loadFromSD(*m_sdTalker, "/config.json")) {
+    m_configReload->report("config: couldn't read /config.json, keeping the running config");
+    return nullptr;
+  }
+
+  ChannelSetup *next = ChannelSetup::build(config, m_setup.load(std::memory_order_acquire)->id + 1, SAMPLE_RING_SIZE);
+  if (next->ring.capacity() == 0) {
+    delete next;
+    m_configReload->report("config: no memory for a second sample ring, keeping the running config");
+    return nullptr;
+  }
+
+  // Handed over whole, the analog task swaps it in between scans
+  next->ring.setConsumer(xTaskGetCurrentTaskHandle(), SD_WATERMARK);
+  m_nextSetup.store(next, std::memory_order_release);
+  return next;
+}
+
+void Control::dumpBurst(ChannelConverter &converter) {
+  static const char *sourceNames[] = {"none", "sequence", "estop", "threshold", "command"};
+
+  const uint8_t *spans[2];
+  size_t counts[2];
+  m_burstCapture->frozenSpans(spans, counts);
+
+  // Reloads wait for the dump, so the whole window was recorded with the live setup
+  const ChannelSetup &setup = *m_setup.load(std::memory_order_acquire);
+  std::vector<String> names, units;
+  setup.columns(names, units);
+
+  char note[96];
+  snprintf(note, sizeof(note), "burst capture, trigger %s at %llu us", sourceNames[(int)m_burstCapture->source()], (unsigned long long)m_burstCapture->triggerTimeUs());
+  SampleLayout layout = setup.layout;
+  converter.describe(layout);
+  m_sdTalker->writeSnapshot("/Logs/burst", note, names, units, spans, counts, layout);
+
+  // Rearm even if the write failed, a stale capture is no use and would block the next trigger
+  m_burstCapture->rearm();
+}
+
 void Control::serialDataTask() {
   char buffer[128];  // Buffer to store incoming data
   int rxIndex = 0;   // Index to track the length of the received message
@@ -365,7 +793,6 @@ void Control::serialDataTask() {
 
         // ESP_LOGI(TAG, "LINE 355");
 
-        m_pauseADC = true;
         if (payload.paramType == 0) {
           // Float parameter
           m_commander->runCommand(payload.commandID, payload.paramFloat);
@@ -373,7 +800,6 @@ void Control::serialDataTask() {
           // String parameter
           m_commander->runCommand(payload.commandID, payload.paramString);
         }
-        m_pauseADC = false;
         // // Wait for ACK for this sequenceID
         // while (m_LoRaCom->isQueued(msg.sequenceID))
         // {
@@ -406,7 +832,6 @@ void Control::loRaDataTask() {
       else if (msg.type == TYPE_COMMAND) {
         CommandPayload payload;
         memcpy(&payload, msg.payload, sizeof(payload));
-        m_pauseADC = true;
         if (payload.paramType == 0) {
           // Float parameter
           m_commander->runCommand(payload.commandID, payload.paramFloat);
@@ -414,12 +839,15 @@ void Control::loRaDataTask() {
           // String parameter
           m_commander->runCommand(payload.commandID, payload.paramString);
         }
-        m_pauseADC = false;
       } else if (msg.type == TYPE_STATUS) {
         StatusPayload payload;
         memcpy(&payload, msg.payload, sizeof(payload));
         String statusMsg = String("status ") + "ID:" + String(msg.senderID) + " RSSI:" + String(payload.rssi) + " battVoltage:" + String(payload.batteryVoltage) + " status:" + String(payload.status) + ("\n");
         m_serialCom->sendData(statusMsg.c_str());
+      } else if (msg.type == TYPE_TEXT) {
+        msg.payload[sizeof(msg.payload) - 1] = '\0';
+        m_serialCom->sendData(reinterpret_cast<const char *>(msg.payload));
+        m_serialCom->sendData("\n");
       }
       // Clear for the next iteration
       memset(&msg, 0, sizeof(msg));
@@ -438,61 +866,61 @@ void Control::statusTask() {
   msg.senderID = DEVICE_ID;
   msg.receiverID = BROADCAST_ID;
   msg.type = TYPE_STATUS;
-  msg.length = sizeof(StatusPayload);
-
-  // Cache channel names for efficiency (static, only initialized once)
-  static bool namesInitialized = false;
-  static char channelNames[8][24];  // 24 chars per name (adjust as needed)
-  if (!namesInitialized) {
-    for (int i = 0; i < 4; ++i) {
-      const auto &ch = m_config->adc1_channels[i];
-      if (!ch.name.empty()) {
-        strncpy(channelNames[i], ch.name.c_str(), sizeof(channelNames[i]) - 1);
-        channelNames[i][sizeof(channelNames[i]) - 1] = '\0';
-      } else {
-        snprintf(channelNames[i], sizeof(channelNames[i]), "IN%d", i + 1);
-      }
-    }
-    for (int i = 0; i < 4; ++i) {
-      const auto &ch = m_config->adc2_channels[i];
-      if (!ch.name.empty()) {
-        strncpy(channelNames[i + 4], ch.name.c_str(), sizeof(channelNames[i + 4]) - 1);
-        channelNames[i + 4][sizeof(channelNames[i + 4]) - 1] = '\0';
-      } else {
-        snprintf(channelNames[i + 4], sizeof(channelNames[i + 4]), "IN%d", i + 5);
-      }
-    }
-    namesInitialized = true;
-  }
+
+  ChannelConverter converter(m_adcProcessors, m_lsbV);
 
   while (true) {
+    // A reload can swap the setup between passes, names and slots come from whichever is live
+    const ChannelSetup &setup = *m_setup.load(std::memory_order_acquire);
+
     StatusPayload payload;
     payload.rssi = static_cast<int8_t>(m_LoRaCom->getRssi());
     payload.batteryVoltage = m_battMonitor->getScaledVoltage(/*num_readings*/ 20);
     payload.status = deviceStatus::STATUS_OK;
 
+    // Everything since the last report. Channels too slow to have been sampled in it, or all of them
+    // if the analog task didn't answer, fall back to their latest value
+    WindowStats::Window window = {};
+    bool haveWindow = m_windowStats.cut(window, pdMS_TO_TICKS(100));
     SampleWithTimestamp sample;
     getLatestSample(sample);
-    payload.IN1 = sample.value1;
-    payload.IN2 = sample.value2;
-    payload.IN3 = sample.value3;
-    payload.IN4 = sample.value4;
-    payload.IN5 = sample.value5;
-    payload.IN6 = sample.value6;
-    payload.IN7 = sample.value7;
-    payload.IN8 = sample.value8;
+    float units[8];
+    converter.convert(sample.counts, units, sample.channelMask);
+    payload.channelMask = setup.activeMask;
+    payload.windowMs = haveWindow ? (uint16_t)std::min<uint64_t>((window.endUs - window.startUs) / 1000, UINT16_MAX) : 0;
+    ChannelSummary summary[8];
+    for (int i = 0; i < 8; ++i) {
+      if (window.count[i] > 0) {
+        summary[i] = {window.min[i], window.max[i], window.mean[i], window.rms[i]};
+      } else {
+        summary[i] = {units[i], units[i], units[i], fabsf(units[i])};
+      }
+    }
+    payload.numDerived = std::min<size_t>(setup.layout.numDerived, MAX_STATUS_DERIVED);
 
+    // Only the channels in use and the derived values that exist go on air
     memcpy(msg.payload, &payload, sizeof(payload));
+    uint8_t *tail = msg.payload + sizeof(payload);
+    for (uint8_t active = payload.channelMask; active; active &= active - 1) {
+      memcpy(tail, &summary[__builtin_ctz(active)], sizeof(ChannelSummary));
+      tail += sizeof(ChannelSummary);
+    }
+    memcpy(tail, sample.derived, payload.numDerived * sizeof(float));
+    msg.length = statusPayloadSize(payload.channelMask, payload.numDerived);
 
     // Use a preallocated buffer for the status message
-    char statusMsg[256];
-    int len = snprintf(statusMsg, sizeof(statusMsg), "status ID:%d RSSI:%d battVoltage:%.3f status:%d", msg.senderID, payload.rssi, payload.batteryVoltage, payload.status);
-    float values[8] = {payload.IN1, payload.IN2, payload.IN3, payload.IN4, payload.IN5, payload.IN6, payload.IN7, payload.IN8};
-    for (int i = 0; i < 8; ++i) {
-      // Append each channel name and value
-      len += snprintf(statusMsg + len, sizeof(statusMsg) - len, " %s:%.2f", channelNames[i], values[i]);
+    char statusMsg[512];
+    int len = snprintf(statusMsg, sizeof(statusMsg), "status ID:%d RSSI:%d battVoltage:%.3f status:%d window:%u", msg.senderID, payload.rssi, payload.batteryVoltage, payload.status, payload.windowMs);
+    for (int slot = 0; slot < setup.layout.numChannels; ++slot) {
+      // Append each active channel's name and mean/min/max/rms, mean first so it still reads as the value
+      int i = setup.layout.channel[slot];
+      const ChannelSummary &ch = summary[i];
+      len += snprintf(statusMsg + len, sizeof(statusMsg) - len, " %s:%.2f/%.2f/%.2f/%.2f", setup.name[i], ch.mean, ch.min, ch.max, ch.rms);
       if (len >= (int)sizeof(statusMsg) - 1) break;
     }
+    for (int d = 0; d < payload.numDerived && len < (int)sizeof(statusMsg) - 1; ++d) {
+      len += snprintf(statusMsg + len, sizeof(statusMsg) - len, " %s:%.2f", setup.config.derived[d].name.c_str(), sample.derived[d]);
+    }
     // Ensure newline and null-termination
     if (len < (int)sizeof(statusMsg) - 2) {
       statusMsg[len++] = '\n';
@@ -506,11 +934,42 @@ void Control::statusTask() {
 
     if (m_LoRaCom->enqueueMessage(msg, false)) ESP_LOGD(TAG, "Adding to transmit queue...");
 
+    // A sequence that ended since the last pass gets its summary out now
+    BurnMonitor::Summary burn;
+    if (m_burnMonitor->takeSummary(burn)) sendBurnSummary(burn);
+
     // checkTaskStack();
     vTaskDelay(pdMS_TO_TICKS(status_Interval));
   }
 }
 
+void Control::sendBurnSummary(const BurnMonitor::Summary &summary) {
+  BurnPayload payload;
+  payload.flags = (summary.burnDetected ? BURN_DETECTED : 0) | (summary.stopped ? BURN_STOPPED : 0) | (summary.cutShort ? BURN_CUT_SHORT : 0) | (summary.havePressure ? BURN_PRESSURE : 0);
+  payload.sequenceS = summary.sequenceS;
+  payload.burnTimeS = summary.burnTimeS;
+  payload.peakThrust = summary.peakThrust;
+  payload.peakThrustTimeS = summary.peakThrustTimeS;
+  payload.totalImpulse = summary.totalImpulse;
+  payload.averageThrust = summary.averageThrust;
+  payload.peakPressure = summary.peakPressure;
+
+  LoRaMessage msg;
+  msg.senderID = DEVICE_ID;
+  msg.receiverID = BROADCAST_ID;
+  msg.type = TYPE_BURN;
+  msg.length = sizeof(BurnPayload);
+  memcpy(msg.payload, &payload, sizeof(payload));
+
+  char line[256];
+  snprintf(line, sizeof(line), "burn ID:%d flags:%u sequence:%.2f burnTime:%.3f peakThrust:%.2f peakTime:%.3f impulse:%.2f avgThrust:%.2f peakPressure:%.2f\n", msg.senderID, payload.flags, payload.sequenceS, payload.burnTimeS, payload.peakThrust, payload.peakThrustTimeS,
+           payload.totalImpulse, payload.averageThrust, payload.peakPressure);
+  m_serialCom->sendData(line);
+
+  // Only sent once per sequence, so unlike status it waits for the ground station to ack it
+  if (!m_LoRaCom->enqueueMessage(msg, true)) ESP_LOGW(TAG, "Transmit queue full, burn summary only went to serial");
+}
+
 void Control::processData(const char *buffer) {
   ESP_LOGD(TAG, "Processing data");
 
@@ -537,58 +996,285 @@ void Control::checkTaskStack() {
 }
 
 void Control::setLatestSample(const SampleWithTimestamp &sample) {
-  SemaphoreGuard Guard_adc(m_latestSampleMutex);
-  if (Guard_adc.acquired()) {
-    m_latestSample = sample;  // Update the latest sample with the new data
-  } else {
-    ESP_LOGW(TAG, "Failed to acquire mutex for latest sample update");
+  // Channels not sampled on this tick keep their previous value. Only the analog task touches m_heldSample
+  for (int ch = 0; ch < 8; ++ch) {
+    if (sample.channelMask & (1 << ch)) m_heldSample.counts[ch] = sample.counts[ch];
   }
-}
-
-void Control::getLatestSample(SampleWithTimestamp &sample) {
-  SemaphoreGuard Guard_adc(m_latestSampleMutex);
-  if (Guard_adc.acquired()) {
-    sample = m_latestSample;  // Copy the latest sample data
-  } else {
-    ESP_LOGW(TAG, "Failed to acquire mutex for latest sample retrieval");
+  m_heldSample.channelMask |= sample.channelMask;
+  m_heldSample.flags = sample.flags;
+  m_heldSample.battery_voltage = sample.battery_voltage;
+  m_heldSample.timestamp = sample.timestamp;
+  if (sample.channelMask) memcpy(m_heldSample.derived, sample.derived, sizeof(sample.derived));
+  for (int ch = 0; ch < 8; ++ch) {
+    if (sample.channelMask & (1 << ch)) m_heldSample.channelOffsetUs[ch] = sample.channelOffsetUs[ch];
   }
+
+  m_latestSample.write(m_heldSample);
 }
 
-void Control::setupADC_Channels(adcADS *adc, std::array<ChannelConfig, 4> &channels, int processorOffset) {
-  for (int i = 0; i < 4; ++i) {
-    ChannelConfig &ch = channels[i];
-    m_adcProcessors[i + processorOffset] = new adcProcessor();
-    m_adcProcessors[i + processorOffset]->setScale(ch.scale_factor);
-
-    ch.mux = -1;
-    if (ch.mode == "differential") {
-      if (ch.inputs == std::vector<int>{0, 1})
-        ch.mux = ADS1X15_REG_CONFIG_MUX_DIFF_0_1;
-      else if (ch.inputs == std::vector<int>{2, 3})
-        ch.mux = ADS1X15_REG_CONFIG_MUX_DIFF_2_3;
-    } else if (ch.mode == "single_ended" && ch.inputs.size() == 1) {
-      if (ch.inputs[0] == 0)
-        ch.mux = ADS1X15_REG_CONFIG_MUX_SINGLE_0;
-      else if (ch.inputs[0] == 1)
-        ch.mux = ADS1X15_REG_CONFIG_MUX_SINGLE_1;
-      else if (ch.inputs[0] == 2)
-        ch.mux = ADS1X15_REG_CONFIG_MUX_SINGLE_2;
-      else if (ch.inputs[0] == 3)
-        ch.mux = ADS1X15_REG_CONFIG_MUX_SINGLE_3;
-    }
-
-    float tareValue = 0.0f;
-    if (ch.tare_bias.auto_tare && ch.mux != -1) {
-      tareValue = adc->getAverageVolt(200, ch.mux);
-    } else {
-      tareValue = ch.tare_bias.value;
+void Control::getLatestSample(SampleWithTimestamp &sample) { m_latestSample.read(sample); }
+
+void Control::configureChannels(const ControlConfig &config, uint8_t channelMask) {
+  std::array<const std::array<ChannelConfig, 4> *, 2> configs = {&config.adc1_channels, &config.adc2_channels};
+  uint8_t autoTareMask = 0;
+  for (int idx = 0; idx < 8; ++idx) {
+    if (!(channelMask & (1 << idx))) continue;
+    const ChannelConfig &ch = (*configs[idx / 4])[idx % 4];
+
+    // Oversampled channels log the sum of their conversions, so each stored count is a fraction of an
+    // LSB, and 32 bit channels carry COUNT_FRACTION_BITS on top
+    float lsbV = ch.auto_gain ? adcADS::lsbForGain(AUTO_GAINS[AUTO_GAIN_LEVELS - 1]) : (idx < 4) ? m_adcADS_12->getLsbV() : m_adcADS_34->getLsbV();
+    m_schedule[idx].gainLevel = 0;
+
+    // Processors stay put once created, every consumer holds on to the array
+    if (m_adcProcessors[idx] == nullptr) m_adcProcessors[idx] = new adcProcessor();
+    adcProcessor *processor = m_adcProcessors[idx];
+
+    // A curve, when configured, takes over from scale_factor
+    CalibrationCurve curve;
+    if (ch.calibration.points.size() >= 2) {
+      CalibrationPoint points[CalibrationCurve::MAX_POINTS];
+      size_t count = std::min(ch.calibration.points.size(), CalibrationCurve::MAX_POINTS);
+      for (size_t p = 0; p < count; ++p) points[p] = {ch.calibration.points[p].first, ch.calibration.points[p].second};
+      curve.compileTable(points, count);
+    } else if (!ch.calibration.polynomial.empty()) {
+      curve.compilePolynomial(ch.calibration.polynomial.data(), ch.calibration.polynomial.size());
+    }
+
+    // The SD, status and display converters copy these from their own tasks, so the LSB and the
+    // processor change together in one update. Auto-tare channels start untared and pick up their
+    // offset from the running stream, see queueSample()
+    adcProcessor::beginUpdate();
+    m_fractionBits[idx] = ch.wideCounts() ? COUNT_FRACTION_BITS : 0;
+    m_lsbV[idx] = lsbV / (ch.oversample * (float)(1 << m_fractionBits[idx]));
+    processor->configure(ch.scale_factor, curve, ch.tare_bias.auto_tare ? 0.0f : ch.tare_bias.value);
+    adcProcessor::endUpdate();
+
+    FilterChain &chain = processor->filters();
+    chain.clear();
+    for (const FilterConfig &filter : ch.filters) {
+      if (filter.type == "notch") {
+        chain.addStage(FilterType::NOTCH, filter.freq_hz, filter.q, 0);
+      } else if (filter.type == "lowpass") {
+        chain.addStage(FilterType::LOWPASS, filter.freq_hz, filter.q, 0);
+      } else if (filter.type == "moving_average") {
+        chain.addStage(FilterType::MOVING_AVERAGE, 0.0f, 0.0f, filter.length);
+      } else {
+        ESP_LOGW(TAG, "CH%d: unknown filter type '%s'", idx + 1, filter.type.c_str());
+      }
     }
-    m_adcProcessors[i + processorOffset]->tareVolts(tareValue);
+
+    if (ch.tare_bias.auto_tare && ch.mux != -1) autoTareMask |= (1 << idx);
   }
+
+  // Channels left alone keep any auto-tare still under way, reconfigured ones start theirs over
+  m_autoTare.restart(channelMask, autoTareMask, AUTO_TARE_SAMPLES);
 }
 
 void Control::setupADC_Config() {
-  setupADC_Channels(m_adcADS_12, m_config->adc1_channels, 0);
-  setupADC_Channels(m_adcADS_34, m_config->adc2_channels, 4);
+  configureChannels(m_setup.load(std::memory_order_relaxed)->config, 0xFF);
+  setupDerivedChannels();
+  setupBurnMonitor();
+  setupAdaptiveLog();
+  setupPlanner();
+  buildSchedule();
   ESP_LOGI(TAG, "ADC configuration setup complete");
-}
\ No newline at end of file
+}
+
+void Control::applySetup(ChannelSetup *next) {
+  ChannelSetup *previous = m_setup.load(std::memory_order_relaxed);
+
+  // Fix how the old setup's records convert before any processor changes, the SD task may still have
+  // some to write out. Curves are copied since the converter's own change with the processors
+  previous->finalLayout = previous->layout;
+  m_converter->describe(previous->finalLayout);
+  for (int slot = 0; slot < previous->finalLayout.numChannels; ++slot) {
+    if (previous->finalLayout.curve[slot] == nullptr) continue;
+    previous->finalCurves[slot] = *previous->finalLayout.curve[slot];
+    previous->finalLayout.curve[slot] = &previous->finalCurves[slot];
+  }
+  previous->retired.store(true, std::memory_order_release);
+
+  // Channels whose signal path is unchanged keep their tare, filter state and gain. Renaming one
+  // only changes the log header
+  std::array<const std::array<ChannelConfig, 4> *, 2> before = {&previous->config.adc1_channels, &previous->config.adc2_channels};
+  std::array<const std::array<ChannelConfig, 4> *, 2> after = {&next->config.adc1_channels, &next->config.adc2_channels};
+  uint8_t changed = 0;
+  for (int idx = 0; idx < 8; ++idx) {
+    if (!(*before[idx / 4])[idx % 4].sameSignal((*after[idx / 4])[idx % 4])) changed |= (1 << idx);
+  }
+  configureChannels(next->config, changed);
+  m_setup.store(next, std::memory_order_release);
+
+  // Nothing stale for the display from channels that changed or went away
+  m_heldSample.channelMask &= next->activeMask & ~changed;
+  memset(m_heldSample.derived, 0, sizeof(m_heldSample.derived));
+  setupDerivedChannels();
+  m_derivedLastUs = 0;
+  setupBurnMonitor();
+  setupAdaptiveLog();
+  setupPlanner();
+
+  ESP_LOGI(TAG, "Config reload %u applied, channels changed 0x%02X", (unsigned)next->id, changed);
+}
+
+void Control::setupDerivedChannels() {
+  const ChannelSetup &setup = *m_setup.load(std::memory_order_relaxed);
+
+  m_derived.clear();
+  for (const DerivedConfig &d : setup.config.derived) {
+    if (m_derived.size() >= DerivedChannels::MAX_CHANNELS) {
+      ESP_LOGW(TAG, "Only %u derived channels are supported, ignoring the rest", (unsigned)DerivedChannels::MAX_CHANNELS);
+      break;
+    }
+    // A bad expression still takes its column so the ones after it keep their Dn numbering
+    if (!m_derived.add(d.expr.c_str())) {
+      ESP_LOGE(TAG, "Derived channel %s will read 0", d.name.c_str());
+      m_derived.add("0");
+    }
+  }
+
+  uint8_t unused = m_derived.inputMask() & ~setup.activeMask;
+  for (int idx = 0; idx < 8; ++idx) {
+    if (unused & (1 << idx)) ESP_LOGW(TAG, "Derived channels read CH%d, which isn't in use and will read 0", idx + 1);
+  }
+}
+
+void Control::setupBurnMonitor() {
+  const ChannelSetup &setup = *m_setup.load(std::memory_order_relaxed);
+  const BurnConfig &burn = setup.config.burn;
+
+  // "CHn" for an active channel or "Dn" for a derived one, anything else turns that input off
+  auto resolve = [&](const std::string &name) -> int8_t {
+    if (name.empty()) return -1;
+    int n = 0;
+    if (sscanf(name.c_str(), "CH%d", &n) == 1 && n >= 1 && n <= 8 && (setup.activeMask & (1 << (n - 1)))) return n - 1;
+    if (sscanf(name.c_str(), "D%d", &n) == 1 && n >= 1 && (size_t)n <= m_derived.size()) return 8 + n - 1;
+    ESP_LOGW(TAG, "Burn summary channel '%s' isn't in use, ignoring it", name.c_str());
+    return -1;
+  };
+  m_burnThrust = resolve(burn.thrust_channel);
+  m_burnPressure = resolve(burn.pressure_channel);
+  m_burnMonitor->setThreshold(burn.thrust_threshold);
+}
+
+void Control::setupAdaptiveLog() {
+  const ChannelSetup &setup = *m_setup.load(std::memory_order_relaxed);
+  std::array<const std::array<ChannelConfig, 4> *, 2> configs = {&setup.config.adc1_channels, &setup.config.adc2_channels};
+  QuietDetector::Band bands[8];
+  for (int idx = 0; idx < 8; ++idx) {
+    const QuietBand &quiet = (*configs[idx / 4])[idx % 4].quiet;
+    bands[idx].enabled = quiet.enabled && (setup.activeMask & (1 << idx));
+    bands[idx].min = quiet.min;
+    bands[idx].max = quiet.max;
+    bands[idx].rate = quiet.rate;
+  }
+  const AdaptiveLogConfig &adaptive = setup.config.adaptive_log;
+  m_quietDetector.configure(bands, (uint64_t)(std::max(0.0f, adaptive.hold_s) * 1e6f));
+  m_adaptiveLog = adaptive.enabled;
+  m_loggingQuiet = false;
+  if (m_adaptiveLog && !m_quietDetector.hasBands()) {
+    // Every record would count as quiet, so the whole run would be logged at the idle rate
+    ESP_LOGW(TAG, "adaptive_log needs a quiet band on at least one active channel, logging at the full rate");
+    m_adaptiveLog = false;
+  }
+}
+
+void Control::setupPlanner() {
+  const ControlConfig &config = m_setup.load(std::memory_order_relaxed)->config;
+  std::array<const std::array<ChannelConfig, 4> *, 2> configs = {&config.adc1_channels, &config.adc2_channels};
+  PlannerChannel channels[8];
+  for (int idx = 0; idx < 8; ++idx) {
+    const ChannelConfig &cfg = (*configs[idx / 4])[idx % 4];
+    channels[idx].active = cfg.mux != -1;
+    channels[idx].sampleRate = cfg.sample_rate;
+    channels[idx].oversample = cfg.oversample;
+  }
+  m_planner->setChannels(channels, BURST_STEP_OVERHEAD_US);
+
+  // Channels without their own sample_rate log at the config's sampling_rate, or as close as the bus allows
+  if (!m_planner->plan(config.sampling_rate, m_plan)) {
+    float maxHz = m_plan.maxLogHz;
+    ESP_LOGW(TAG, "sampling_rate %d Hz is more than the ADCs can manage, %.1f Hz at most", config.sampling_rate, maxHz);
+    if (maxHz <= 0.0f || !m_planner->plan(maxHz, m_plan)) {
+      // The channels with their own rates are too much on their own, run flat out and let buildSchedule() warn
+      m_plan = AcquisitionPlan();
+      m_plan.logHz = (maxHz > 0.0f) ? maxHz : config.sampling_rate;
+    }
+  }
+  m_planner->setActive(m_plan);
+}
+
+float Control::burstTickRate() const {
+  // Both ADCs convert together at their fastest rate, so a scan takes as many steps as the busier ADC has channels
+  const SampleLayout &layout = m_setup.load(std::memory_order_relaxed)->layout;
+  int perAdc[2] = {0, 0};
+  for (int slot = 0; slot < layout.numChannels; ++slot) perAdc[layout.channel[slot] / 4]++;
+  int steps = std::max(1, std::max(perAdc[0], perAdc[1]));
+  uint32_t stepUs = adcADS::conversionUsAt(adcADS::dataRateSps(adcADS::NUM_DATA_RATES - 1)) + BURST_STEP_OVERHEAD_US;
+  return 1e6f / (float)(steps * stepUs);
+}
+
+void Control::setupBurstCapture() {
+  // Room for the pre-trigger window at the normal tick and the post-trigger window at the burst tick
+  const ChannelSetup &setup = *m_setup.load(std::memory_order_relaxed);
+  const BurstConfig &burst = setup.config.burst;
+  size_t capacity = (size_t)ceilf(burst.pre_trigger_s * m_tickRateHz + burst.post_trigger_s * burstTickRate());
+  m_burstCapture->begin(capacity, setup.layout.recordSize, (uint64_t)(burst.post_trigger_s * 1e6f));
+}
+
+void Control::buildSchedule(bool burst) {
+  const ControlConfig &config = m_setup.load(std::memory_order_relaxed)->config;
+  std::array<const std::array<ChannelConfig, 4> *, 2> configs = {&config.adc1_channels, &config.adc2_channels};
+
+  // Bursts always convert flat out, otherwise the plan picks the data rate
+  uint16_t sps = burst ? adcADS::dataRateSps(adcADS::NUM_DATA_RATES - 1) : m_plan.dataRateSps;
+  m_adcADS_12->setDataRate(sps);
+  m_adcADS_34->setDataRate(sps);
+  uint16_t decimation = burst ? 1 : m_plan.decimation;
+
+  // The tick runs at the fastest channel conversion rate, slower channels are read every `divider` ticks.
+  // Oversampled channels convert `oversample * decimation` times faster than they log
+  m_tickRateHz = 0.0f;
+  float burstHz = burstTickRate();
+  for (int idx = 0; idx < 8; ++idx) {
+    const ChannelConfig &cfg = (*configs[idx / 4])[idx % 4];
+    if (cfg.mux == -1) continue;
+    float rate = burst ? burstHz : ((cfg.sample_rate > 0.0f) ? cfg.sample_rate : m_plan.logHz) * cfg.oversample * decimation;
+    m_tickRateHz = std::max(m_tickRateHz, rate);
+  }
+  if (m_tickRateHz <= 0.0f) m_tickRateHz = ADC_SPS;
+
+  // Stagger the phases of slow channels on each ADC so they don't all land on the same tick
+  uint16_t nextPhase[2] = {0, 0};
+  for (int idx = 0; idx < 8; ++idx) {
+    const ChannelConfig &cfg = (*configs[idx / 4])[idx % 4];
+    ChannelSchedule &sched = m_schedule[idx];
+    uint8_t gainLevel = sched.gainLevel;  // the signal hasn't changed just because the schedule has
+    sched = ChannelSchedule();
+    if (cfg.mux == -1) continue;
+
+    float rate = burst ? burstHz : ((cfg.sample_rate > 0.0f) ? cfg.sample_rate : m_plan.logHz) * cfg.oversample * decimation;
+    sched.active = true;
+    sched.oversample = cfg.oversample;
+    sched.decimation = decimation;
+    sched.autoGain = cfg.auto_gain;
+    if (sched.autoGain) sched.gainLevel = gainLevel;
+    sched.targetHz = rate / (cfg.oversample * decimation);
+    sched.divider = std::max(1, (int)lroundf(m_tickRateHz / rate));
+    if (sched.divider > 1) sched.phase = nextPhase[idx / 4]++ % sched.divider;
+
+    float plannedHz = m_tickRateHz / sched.divider;
+    // Biquad coefficients depend on the rate this channel is actually logged at
+    if (m_adcProcessors[idx]) m_adcProcessors[idx]->filters().setSampleRate(plannedHz / (cfg.oversample * decimation));
+    if (fabsf(plannedHz - rate) > RATE_TOLERANCE * rate) {
+      ESP_LOGW(TAG, "CH%d can only convert at %.1f Hz (target %.1f Hz) with a %.1f Hz tick", idx + 1, plannedHz, rate, m_tickRateHz);
+    }
+    if (!burst && rate > burstHz) {
+      ESP_LOGW(TAG, "CH%d needs %.1f conversions/s, more than the %.1f scans/s the ADCs can manage", idx + 1, rate, burstHz);
+    }
+  }
+
+  m_tick = 0;
+  ESP_LOGI(TAG, "Acquisition tick %.1f Hz at %u SPS, decimation %u%s", m_tickRateHz, sps, decimation, burst ? " (burst)" : "");
+}
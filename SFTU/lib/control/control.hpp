@@ -14,14 +14,31 @@
 #include "display.hpp"
 #include "driver/timer.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
 #ifdef SFTU
 #include "BattMonitor.hpp"
+#include "AcquisitionPlanner.hpp"
+#include "AutoTare.hpp"
+#include "BurnMonitor.hpp"
+#include "BurstCapture.hpp"
+#include "CalibrationCapture.hpp"
+#include "ChannelConverter.hpp"
+#include "ChannelSetup.hpp"
+#include "ConfigReload.hpp"
 #include "ControlConfig.hpp"
+#include "DerivedChannels.hpp"
+#include "LogDecimator.hpp"
 // #include "PTProcessing.hpp"
 #include "SD_Talker.hpp"
+#include "SampleClock.hpp"
+#include "SeqLock.hpp"
+#include "QuietDetector.hpp"
+#include "SpectrumAnalyzer.hpp"
+#include "SpscRing.hpp"
+#include "WindowStats.hpp"
 #include "actuation.hpp"
 #include "esp_task_wdt.h"
 // #include "loadCellProcessing.hpp"
@@ -77,6 +94,8 @@ class Control {
 
   // Use arrays for multiple adcProcessor instances
   adcProcessor *m_adcProcessors[8] = {nullptr};
+  float m_lsbV[8] = {0};  // volts per count for each channel, from its ADC's gain
+  uint8_t m_fractionBits[8] = {0};  // COUNT_FRACTION_BITS for channels logged at 32 bits, else 0
 
   // Optionally, for clarity, you can use enum or comments to indicate usage
   // enum { LOAD_CELL_1, PRESS_TRAN_1, ... };
@@ -86,6 +105,14 @@ class Control {
 #ifdef SFTU
   Actuation *m_actuation;
   ControlConfig *m_config;
+  SampleClock *m_sampleClock;
+  BurstCapture *m_burstCapture;
+  ChannelConverter *m_converter;
+  CalibrationCapture *m_calCapture;
+  SpectrumAnalyzer *m_spectrum;
+  AcquisitionPlanner *m_planner;
+  ConfigReload *m_configReload;
+  BurnMonitor *m_burnMonitor;
 #else
   SaveFlash *m_saveFlash;
 #endif
@@ -99,6 +126,7 @@ class Control {
   unsigned long lora_Interval = 50;
   unsigned long status_Interval = 2'000;
   unsigned long heartBeat_Interval = 1'000;
+  unsigned long acquisitionStats_Interval = 10'000;
 
   static constexpr const char *TAG = "Control";
 
@@ -132,6 +160,7 @@ class Control {
   void sdTask();
   void displayTask();
   void checkTaskStack();
+  void logAcquisitionStats();
 
   void setLatestSample(const SampleWithTimestamp &sample);
   void getLatestSample(SampleWithTimestamp &sample);
@@ -142,8 +171,84 @@ class Control {
   void processData(const char *buffer);
   void queueSample();
 
-  void setupADC_Channels(adcADS *adc, std::array<ChannelConfig, 4> &channels, int processorOffset);
+  void configureChannels(const ControlConfig &config, uint8_t channelMask);
   void setupADC_Config();
+  void setupPlanner();
+  void buildSchedule(bool burst = false);
+  void setupDerivedChannels();
+  void setupBurnMonitor();
+  void setupAdaptiveLog();
+  float burstTickRate() const;
+  void setupBurstCapture();
+  void packSample(const SampleWithTimestamp &sample, const SampleLayout &layout, uint8_t *record) const;
+  void dumpBurst(ChannelConverter &converter);
+
+  void sendBurnSummary(const BurnMonitor::Summary &summary);
+
+  void applySetup(ChannelSetup *next);
+  ChannelSetup *reloadConfig();
+
+  // Within tolerance of its target rate a channel is considered on schedule
+  static constexpr float RATE_TOLERANCE = 0.05f;
+
+  // Auto-ranging gain ladder, lowest gain first. 2/3 is left out, +/-4.096 V already covers the supply
+  static constexpr adsGain_t AUTO_GAINS[] = {GAIN_ONE, GAIN_TWO, GAIN_FOUR, GAIN_EIGHT, GAIN_SIXTEEN};
+  static constexpr uint8_t AUTO_GAIN_LEVELS = sizeof(AUTO_GAINS) / sizeof(AUTO_GAINS[0]);
+  static constexpr int32_t AUTO_GAIN_UP = 29491;    // 90% of full scale, drop a gain level straight away
+  static constexpr int32_t AUTO_GAIN_DOWN = 13107;  // 40%, still under 90% once the gain doubles
+  static constexpr uint16_t AUTO_GAIN_WINDOW = 64;  // conversions that must stay under AUTO_GAIN_DOWN before raising it
+  int32_t autoRange(int idx, int16_t raw);
+
+  // Channel idx is converted on ticks where (tick % divider) == phase
+  struct ChannelSchedule {
+    bool active = false;
+    uint16_t divider = 1;
+    uint16_t phase = 0;
+    float targetHz = 0.0f;  // output rate, conversions run `oversample` times faster
+    uint32_t samples = 0;   // samples emitted since the last stats report
+
+    // Oversampling: `oversample` conversions are summed and emitted as one sample. The plan's
+    // decimation averages that many sums on top, which leaves the meaning of a count alone
+    uint16_t oversample = 1;
+    uint16_t decimation = 1;
+    uint16_t pending = 0;  // conversions in the current sum
+    int32_t sum = 0;
+
+    // Auto-ranging PGA: level indexes AUTO_GAINS, conversions are shifted up to the highest gain's LSB
+    bool autoGain = false;
+    uint8_t gainLevel = 0;
+    int32_t gainWindowPeak = 0;  // largest |counts| since the last range check
+    uint16_t gainWindowCount = 0;
+    uint32_t gainSwitches = 0;  // since the last stats report
+
+    // Noise estimates from first differences, reset every stats report
+    int32_t lastRaw = 0;
+    int32_t lastSum = 0;
+    bool haveSum = false;
+    float rawDiffSq = 0.0f;  // LSB^2
+    uint32_t rawDiffs = 0;
+    float sumDiffSq = 0.0f;  // LSB^2, of the sums scaled back to single conversions
+    uint32_t sumDiffs = 0;
+  };
+  ChannelSchedule m_schedule[8];
+  float m_tickRateHz = ADC_SPS;
+  AcquisitionPlan m_plan;  // data rate and decimation the schedule is built from, analog task only
+  bool m_burstRate = false;  // schedule currently running every channel flat out for a burst capture
+  uint32_t m_tick = 0;
+
+  // One step of a scan: the channel converted on each ADC at the same time, -1 if that ADC is idle
+  struct ScanStep {
+    int8_t channel[2];
+  };
+
+  struct ScanStats {
+    uint32_t count = 0;
+    uint64_t totalUs = 0;
+    uint32_t minUs = UINT32_MAX;
+    uint32_t maxUs = 0;
+    uint32_t windowStartUs = 0;
+  };
+  ScanStats m_scanStats;
 
   String deviceID = "SFTU";  // Unique identifier for the device
 
@@ -151,12 +256,49 @@ class Control {
   String m_mode = "transceive";
   String m_status = "ok";  // Status of the device (e.g., "ok", "error", etc.)
   float m_batteryVoltage = 0;
-  volatile bool m_pauseADC = false;  // Flag to pause ADC sampling
-
-  xQueueHandle m_adcQueue;
 
-  SemaphoreHandle_t m_latestSampleMutex = nullptr;
-  SampleWithTimestamp m_latestSample;
+  // Samples from the analog task to the SD task. From testing, the backlog reaches ~200 samples during an SD write
+  static constexpr size_t SAMPLE_RING_SIZE = 1024;
+  static constexpr size_t SD_WATERMARK = 256;  // wake the SD task once this many samples are waiting
+
+  // Channel setup the analog task is acquiring with, see ChannelSetup. Only the analog task stores it.
+  // Other tasks load it afresh for each pass or call and never keep it across a wait
+  std::atomic<ChannelSetup *> m_setup{nullptr};
+  // Built by the SD task from a reloaded config, taken by the analog task between scans
+  std::atomic<ChannelSetup *> m_nextSetup{nullptr};
+  // Last setup the SD task finished with, freed when the next one retires. SD task only
+  ChannelSetup *m_retiredSetup = nullptr;
+  // A reload is refused until the last one has been live this long, so a setup is only freed well
+  // after any pass that loaded it before it was swapped out has finished
+  static constexpr uint32_t RELOAD_HOLDOFF_MS = 2000;
+
+  // Allowance per scan step for the I2C traffic around each conversion
+  static constexpr uint32_t BURST_STEP_OVERHEAD_US = 150;
+
+  // Auto-tare offsets come from each channel's first samples once acquisition is running
+  AutoTare m_autoTare;
+  static constexpr uint32_t AUTO_TARE_SAMPLES = 200;
+
+  // Compiled from the config at setup, evaluated by the analog task on the latest value of every channel
+  DerivedChannels m_derived;
+  float m_derivedInputs[8] = {0};
+  uint64_t m_derivedLastUs = 0;
+
+  // Written by the analog task without ever blocking, read by the display and status tasks
+  SeqLock<SampleWithTimestamp> m_latestSample;
+  SampleWithTimestamp m_heldSample = {};
+
+  // Per-channel summary between status reports, filled by the analog task and cut by the status task
+  WindowStats m_windowStats;
+
+  // Burn summary inputs: 0-7 a channel, 8-11 a derived channel, -1 none. Analog task only
+  int8_t m_burnThrust = -1;
+  int8_t m_burnPressure = -1;
+
+  // Adaptive logging: the analog task flags quiet records, the SD task thins them out with a LogDecimator
+  QuietDetector m_quietDetector;
+  bool m_adaptiveLog = false;  // analog task only, from the live setup's config
+  bool m_loggingQuiet = false;
 
   // Data payload;
 };
\ No newline at end of file
@@ -81,9 +81,11 @@ void outputSequencer::taskLoop() {
     SeqCommand cmd;
     while (xQueueReceive(m_cmdQueue, &cmd, 0) == pdTRUE) {
       if (cmd.type == CmdType::Stop) {
+        bool wasRunning = activeSeq != &empty;
         seqRunning = false;
         m_actuation->setAllClear();
         activeSeq = &empty;
+        if (wasRunning && m_onEnd) m_onEnd(true, m_hookArg);
       } else if (cmd.type == CmdType::Start) {
         // Enforce start guard
         if ((millis() - lastSequenceStart > NEXT_SEQ_PERIOD) || m_firstRun) {
@@ -96,6 +98,7 @@ void outputSequencer::taskLoop() {
             m_firstRun = false;
             lastSequenceStart = millis();
             blockStartMs = 0;  // start immediately
+            if (m_onStart) m_onStart(m_hookArg);
           } else {
             Serial.printf("Sequence with UID %d not found.\n", cmd.uid);
           }
@@ -110,6 +113,7 @@ void outputSequencer::taskLoop() {
         seqRunning = false;
         m_actuation->setAllClear();  // automatically turn off all outputs at end of sequence
         activeSeq = &empty;
+        if (m_onEnd) m_onEnd(false, m_hookArg);
       } else {
         const auto &block = (*activeSeq)[blockIndex];
         if (blockStartMs == 0) {
@@ -129,7 +133,16 @@ void outputSequencer::taskLoop() {
   }
 }
 
+void outputSequencer::setEventHooks(EventHook onStart, EventHook onEStop, EndHook onEnd, void *arg) {
+  m_hookArg = arg;
+  m_onStart = onStart;
+  m_onEStop = onEStop;
+  m_onEnd = onEnd;
+}
+
 void outputSequencer::stopFromISR() {
+  if (m_onEStop) m_onEStop(m_hookArg);
+
   // ISR-safe way to request stop: enqueue a Stop command from ISR
   if (m_cmdQueue) {
     SeqCommand cmd{CmdType::Stop, 0};
@@ -28,6 +28,13 @@ class outputSequencer {
   // ISR-safe stop (queues using FromISR)
   void stopFromISR();
 
+  // Let other modules react to sequence events. onStart runs in the sequencer task when a sequence
+  // actually begins, onEStop runs inside stopFromISR() so it must be ISR safe. onEnd runs in the
+  // sequencer task once a running sequence finishes, `stopped` when it was cut off by a stop
+  using EventHook = void (*)(void *arg);
+  using EndHook = void (*)(bool stopped, void *arg);
+  void setEventHooks(EventHook onStart, EventHook onEStop, EndHook onEnd, void *arg);
+
  private:
   // Internal command types for the sequencer task
   enum class CmdType : uint8_t { Start = 0, Stop = 1 };
@@ -40,6 +47,11 @@ class outputSequencer {
   Actuation *m_actuation;
   volatile bool seqRunning = false;
 
+  EventHook m_onStart = nullptr;
+  EventHook m_onEStop = nullptr;
+  EndHook m_onEnd = nullptr;
+  void *m_hookArg = nullptr;
+
   unsigned long lastSequenceStart;
   bool m_firstRun;
 
@@ -0,0 +1,134 @@
+#include "SampleClock.hpp"
+
+#include "TaskNotify.hpp"
+#include "esp_timer.h"
+
+SampleClock::SampleClock(timer_group_t group, timer_idx_t timer) : m_group(group), m_timer(timer) {}
+
+bool SampleClock::begin(float rateHz, TaskHandle_t task, uint32_t notifyBit) {
+  if (rateHz <= 0.0f || task == nullptr) return false;
+  if (m_running) stop();
+
+  m_periodUs = (uint32_t)lroundf(1e6f / rateHz);
+  m_task = task;
+  m_notifyBit = notifyBit;
+
+  timer_config_t config = {};
+  config.alarm_en = TIMER_ALARM_EN;
+  config.counter_en = TIMER_PAUSE;
+  config.intr_type = TIMER_INTR_LEVEL;
+  config.counter_dir = TIMER_COUNT_UP;
+  config.auto_reload = TIMER_AUTORELOAD_EN;  // reload in hardware so the period never drifts
+  config.divider = TIMER_DIVIDER;
+
+  esp_err_t err = timer_init(m_group, m_timer, &config);
+  err |= timer_set_counter_value(m_group, m_timer, 0);
+  err |= timer_set_alarm_value(m_group, m_timer, m_periodUs);
+  err |= timer_enable_intr(m_group, m_timer);
+  err |= timer_isr_callback_add(m_group, m_timer, SampleClock::onAlarm, this, 0);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to configure sample timer");
+    return false;
+  }
+
+  resetStats();
+  m_lastAlarmCount = m_alarmCount;
+
+  timer_start(m_group, m_timer);
+  m_running = true;
+
+  ESP_LOGI(TAG, "Sample clock running at %.1f Hz (%u us)", rateHz, m_periodUs);
+  return true;
+}
+
+void SampleClock::stop() {
+  if (!m_running) return;
+  timer_pause(m_group, m_timer);
+  timer_isr_callback_remove(m_group, m_timer);
+  timer_deinit(m_group, m_timer);
+  m_running = false;
+}
+
+void SampleClock::setRate(float rateHz) {
+  if (!m_running || rateHz <= 0.0f) return;
+
+  m_periodUs = (uint32_t)lroundf(1e6f / rateHz);
+  timer_set_alarm_value(m_group, m_timer, m_periodUs);
+
+  // The interval across the change is neither period, start over from the next sample
+  portENTER_CRITICAL(&m_statsMux);
+  m_stats.periodUs = m_periodUs;
+  m_stats.rateChanges++;
+  portEXIT_CRITICAL(&m_statsMux);
+  m_lastSampleUs = 0;
+
+  ESP_LOGI(TAG, "Sample clock changed to %.1f Hz (%u us)", rateHz, m_periodUs);
+}
+
+bool IRAM_ATTR SampleClock::onAlarm(void *arg) {
+  SampleClock *self = static_cast<SampleClock *>(arg);
+  self->m_alarmCount++;
+
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+  xTaskNotifyFromISR(self->m_task, self->m_notifyBit, eSetBits, &xHigherPriorityTaskWoken);
+  return xHigherPriorityTaskWoken == pdTRUE;
+}
+
+bool SampleClock::waitForTick() {
+  TickType_t timeout = pdMS_TO_TICKS(2 * m_periodUs / 1000) + 1;
+  return taskNotifyWaitBits(m_notifyBit, timeout);
+}
+
+void SampleClock::markSample() {
+  int64_t nowUs = esp_timer_get_time();
+  uint32_t alarms = m_alarmCount;
+
+  if (m_lastSampleUs == 0) {
+    m_lastSampleUs = nowUs;
+    m_lastAlarmCount = alarms;
+    return;
+  }
+
+  uint32_t intervalUs = (uint32_t)(nowUs - m_lastSampleUs);
+  int32_t deviationUs = (int32_t)intervalUs - (int32_t)m_periodUs;
+  uint32_t jitterUs = (uint32_t)abs(deviationUs);
+
+  int32_t offsetUs = deviationUs + (JITTER_BINS / 2) * JITTER_BIN_US;
+  int bin = (offsetUs < 0) ? 0 : std::min<int32_t>(offsetUs / JITTER_BIN_US, JITTER_BINS - 1);
+
+  portENTER_CRITICAL(&m_statsMux);
+  m_stats.count++;
+  m_stats.bins[bin]++;
+  if (intervalUs < m_stats.minIntervalUs) m_stats.minIntervalUs = intervalUs;
+  if (intervalUs > m_stats.maxIntervalUs) m_stats.maxIntervalUs = intervalUs;
+  if (jitterUs > m_stats.maxJitterUs) m_stats.maxJitterUs = jitterUs;
+  if (alarms - m_lastAlarmCount > 1) m_stats.missedTicks += alarms - m_lastAlarmCount - 1;
+  portEXIT_CRITICAL(&m_statsMux);
+
+  m_lastSampleUs = nowUs;
+  m_lastAlarmCount = alarms;
+}
+
+JitterStats SampleClock::getStats() {
+  portENTER_CRITICAL(&m_statsMux);
+  JitterStats stats = m_stats;
+  portEXIT_CRITICAL(&m_statsMux);
+  return stats;
+}
+
+void SampleClock::resetStats() {
+  portENTER_CRITICAL(&m_statsMux);
+  m_stats = JitterStats();
+  m_stats.periodUs = m_periodUs;
+  portEXIT_CRITICAL(&m_statsMux);
+}
+
+int SampleClock::formatStats(char *buffer, size_t len) {
+  JitterStats stats = getStats();
+  int n = snprintf(buffer, len, "timing period:%uus changes:%u n:%u min:%uus max:%uus jitter:%uus missed:%u hist(%dus):", stats.periodUs, stats.rateChanges, stats.count, stats.count ? stats.minIntervalUs : 0, stats.maxIntervalUs,
+                   stats.maxJitterUs, stats.missedTicks, JITTER_BIN_US);
+  for (int i = 0; i < JITTER_BINS && n < (int)len; ++i) {
+    n += snprintf(buffer + n, len - n, i == 0 ? "%u" : ",%u", stats.bins[i]);
+  }
+  return n;
+}
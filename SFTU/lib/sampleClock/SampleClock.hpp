@@ -0,0 +1,73 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "driver/timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define JITTER_BINS 16
+#define JITTER_BIN_US 50  // each bin covers 50 us of deviation from the nominal period
+
+// Inter-sample intervals seen by the acquisition task, binned by deviation from the nominal period.
+// Bin JITTER_BINS/2 holds [0, JITTER_BIN_US) late, the first and last bins catch everything beyond.
+// Deviations are in us whatever the period, so the stats carry on across rate changes (a burst
+// switch, a new plan) and cover every period since the last reset; the interval limits do too.
+struct JitterStats {
+  uint32_t periodUs = 0;     // the current one
+  uint32_t rateChanges = 0;  // since the reset
+  uint32_t count = 0;
+  uint32_t minIntervalUs = UINT32_MAX;
+  uint32_t maxIntervalUs = 0;
+  uint32_t maxJitterUs = 0;
+  uint32_t missedTicks = 0;  // timer alarms that fired while the previous sample was still running
+  uint32_t bins[JITTER_BINS] = {0};
+};
+
+// Hardware timer that paces acquisition. Every alarm sets `notifyBit` on the acquisition task.
+class SampleClock {
+ public:
+  SampleClock(timer_group_t group = TIMER_GROUP_0, timer_idx_t timer = TIMER_0);
+
+  bool begin(float rateHz, TaskHandle_t task, uint32_t notifyBit);
+  void stop();
+
+  // Change the period of a running clock, takes effect from the next alarm. The stats keep going
+  void setRate(float rateHz);
+
+  // Block until the next alarm, returns false if none arrived within two periods
+  bool waitForTick();
+
+  // Call once per sample from the acquisition task to record the interval since the last one
+  void markSample();
+
+  JitterStats getStats();
+  void resetStats();
+
+  // One-line summary of the histogram for serial/LoRa replies
+  int formatStats(char *buffer, size_t len);
+
+  uint32_t getPeriodUs() const { return m_periodUs; }
+
+ private:
+  static bool IRAM_ATTR onAlarm(void *arg);
+
+  timer_group_t m_group;
+  timer_idx_t m_timer;
+  bool m_running = false;
+
+  uint32_t m_periodUs = 0;
+  TaskHandle_t m_task = nullptr;
+  uint32_t m_notifyBit = 0;
+
+  volatile uint32_t m_alarmCount = 0;
+  uint32_t m_lastAlarmCount = 0;
+  int64_t m_lastSampleUs = 0;
+
+  portMUX_TYPE m_statsMux = portMUX_INITIALIZER_UNLOCKED;
+  JitterStats m_stats;
+
+  static constexpr uint32_t TIMER_DIVIDER = 80;  // 80 MHz APB clock -> 1 us per count
+  static constexpr const char *TAG = "SampleClock";
+};
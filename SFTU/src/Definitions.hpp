@@ -17,6 +17,11 @@
 #define AUX_1 39
 #define AUX_2 40
 
+// ADS1115 ALERT/RDY lines. -1 times each conversion out instead. Set to AUX_1 / AUX_2 once the board
+// has ALERT/RDY wired to the AUX header, a pin that never fires is dropped at runtime (see adcADS)
+#define ADS0_RDY -1
+#define ADS1_RDY -1
+
 // RF LoRa
 #define RF_RST 8
 #define RF_DIO 9
@@ -0,0 +1,61 @@
+#pragma once
+
+// Just enough of the Arduino core for the native tests, on the simulated clock in MockClock.hpp
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "MockClock.hpp"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define LOW 0
+#define HIGH 1
+#define RISING 0x01
+#define FALLING 0x02
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+inline unsigned long micros() { return (unsigned long)mock::nowUs; }
+inline unsigned long millis() { return (unsigned long)(mock::nowUs / 1000); }
+inline void delayMicroseconds(uint32_t us) {
+  mock::busyUs += us;
+  mock::advanceTo(mock::nowUs + us);
+}
+inline void delay(uint32_t ms) { mock::advanceTo(mock::nowUs + ms * 1000ULL); }
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline int digitalPinToInterrupt(int pin) { return pin; }
+inline void attachInterruptArg(int, void (*handler)(void *), void *arg, int) {
+  mock::isr = handler;
+  mock::isrArg = arg;
+}
+inline void detachInterrupt(int) {
+  mock::isr = nullptr;
+  mock::isrArg = nullptr;
+}
+
+// The cycle counter runs at 240 MHz of simulated time
+class MockEsp {
+ public:
+  uint32_t getCycleCount() { return (uint32_t)(mock::nowUs * 240); }
+};
+inline MockEsp ESP;
+
+class MockSerial {
+ public:
+  size_t println(const char *) { return 0; }
+};
+inline MockSerial Serial;
@@ -0,0 +1,40 @@
+#pragma once
+
+// Simulated time for the native tests. Nothing advances it but delays and blocking waits, so
+// latencies come out the same on every run and host.
+
+#include <stdint.h>
+
+#include <algorithm>
+
+namespace mock {
+
+// Simulated clock, in us
+inline uint64_t nowUs = 0;
+// Time spent in delayMicroseconds(), i.e. with the CPU spinning rather than blocked
+inline uint64_t busyUs = 0;
+
+// One GPIO interrupt, and the time its next edge is due (UINT64_MAX for none)
+inline void (*isr)(void *) = nullptr;
+inline void *isrArg = nullptr;
+inline uint64_t edgeAtUs = UINT64_MAX;
+
+// Move the clock to `us`, running the interrupt for any edge on the way
+inline void advanceTo(uint64_t us) {
+  while (edgeAtUs <= us) {
+    nowUs = std::max(nowUs, edgeAtUs);
+    edgeAtUs = UINT64_MAX;
+    if (isr) isr(isrArg);
+  }
+  nowUs = std::max(nowUs, us);
+}
+
+inline void reset() {
+  nowUs = 0;
+  busyUs = 0;
+  isr = nullptr;
+  isrArg = nullptr;
+  edgeAtUs = UINT64_MAX;
+}
+
+}  // namespace mock
@@ -0,0 +1,64 @@
+#pragma once
+
+// I2C bus with a single ADS1115 on it, modelled at the register level
+
+#include "Arduino.h"
+
+namespace mock {
+
+struct Ads1115 {
+  uint8_t pointer = 0;
+  uint16_t config = 0x8583;  // power-on default
+  int16_t result = 1234;     // what every conversion reads back
+  uint64_t doneAtUs = 0;
+  bool rdyWired = true;  // whether ALERT/RDY reaches the GPIO
+  uint32_t conversions = 0;
+
+  // A config write with OS set starts a single-shot conversion, 1 / data rate long
+  void write(const uint8_t *bytes, size_t len) {
+    if (len == 0) return;
+    pointer = bytes[0];
+    if (len < 3 || pointer != 0x01) return;
+    config = (uint16_t)((bytes[1] << 8) | bytes[2]);
+    if (!(config & 0x8000)) return;
+    static constexpr uint32_t SPS[8] = {8, 16, 32, 64, 128, 250, 475, 860};
+    doneAtUs = nowUs + 1000000 / SPS[(config >> 5) & 0x7];
+    conversions++;
+    if (rdyWired) edgeAtUs = doneAtUs;
+  }
+
+  uint16_t read() const {
+    if (pointer == 0x00) return (uint16_t)result;
+    if (pointer == 0x01) return (nowUs >= doneAtUs) ? (config | 0x8000) : (config & ~0x8000);
+    return 0;
+  }
+};
+inline Ads1115 ads;
+
+}  // namespace mock
+
+class TwoWire {
+ public:
+  void beginTransmission(uint8_t) { m_len = 0; }
+  size_t write(uint8_t b) {
+    if (m_len < sizeof(m_tx)) m_tx[m_len++] = b;
+    return 1;
+  }
+  uint8_t endTransmission(bool = true) {
+    mock::ads.write(m_tx, m_len);
+    return 0;
+  }
+  uint8_t requestFrom(uint8_t, size_t len) {
+    m_rx = mock::ads.read();
+    m_rxIndex = 0;
+    return (uint8_t)len;
+  }
+  int read() { return (m_rxIndex++ == 0) ? (m_rx >> 8) : (m_rx & 0xFF); }
+
+ private:
+  uint8_t m_tx[3] = {0};
+  size_t m_len = 0;
+  uint16_t m_rx = 0;
+  int m_rxIndex = 0;
+};
+inline TwoWire Wire;
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../MockClock.hpp"
+#include "FreeRTOS.h"
+
+namespace mock {
+
+// Notification value of the one task
+inline uint32_t notifyValue = 0;
+inline uint32_t notifyGives = 0;
+inline TaskHandle_t const currentTask = (TaskHandle_t)1;
+
+}  // namespace mock
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return mock::currentTask; }
+inline TickType_t xTaskGetTickCount() { return (TickType_t)(mock::nowUs / 1000); }
+inline void vTaskDelay(TickType_t ticks) { mock::advanceTo((mock::nowUs / 1000 + ticks) * 1000); }
+
+inline BaseType_t xTaskNotify(TaskHandle_t, uint32_t value, eNotifyAction) {
+  mock::notifyValue |= value;
+  return pdPASS;
+}
+inline BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t *woken) {
+  if (woken) *woken = pdTRUE;
+  return xTaskNotify(task, value, action);
+}
+inline BaseType_t xTaskNotifyGive(TaskHandle_t) {
+  mock::notifyGives++;
+  return pdPASS;
+}
+
+// Blocks by running the clock forward to the next edge or the timeout, whichever comes first
+inline BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t *value, TickType_t timeout) {
+  mock::notifyValue &= ~clearOnEntry;
+  uint64_t deadlineUs = (mock::nowUs / 1000 + timeout) * 1000;
+  while (mock::notifyValue == 0 && mock::nowUs < deadlineUs) mock::advanceTo(std::min(mock::edgeAtUs, deadlineUs));
+  if (mock::notifyValue == 0) return pdFALSE;
+  if (value) *value = mock::notifyValue;
+  mock::notifyValue &= ~clearOnExit;
+  return pdTRUE;
+}
@@ -0,0 +1,167 @@
+#include <unity.h>
+
+// Built straight from source, the library folders pull in hardware-only code
+#include "AcquisitionPlanner.cpp"
+#include "adcADS.cpp"
+
+// AcquisitionPlanner choices of data rate and decimation, and the ADC and CPU load caps
+
+static constexpr uint32_t OVERHEAD_US = 150;  // the burst step overhead control.cpp plans with
+
+static AcquisitionPlanner planner;
+static PlannerChannel channels[8];
+
+void setUp() {
+  for (PlannerChannel &ch : channels) ch = PlannerChannel();
+  planner.setChannels(channels, OVERHEAD_US);
+}
+
+void tearDown() {}
+
+static float stepS(uint16_t sps, uint32_t overheadUs = OVERHEAD_US) {
+  return (adcADS::conversionUsAt(sps) + overheadUs) / 1e6f;
+}
+
+static void test_empty_channel_set() {
+  AcquisitionPlan plan;
+  TEST_ASSERT_TRUE(planner.plan(100.0f, plan));
+  // Nothing to convert, so nothing caps the rate and the slowest data rate wins the tie
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, plan.maxLogHz);
+  TEST_ASSERT_EQUAL_UINT(8, plan.dataRateSps);
+  TEST_ASSERT_EQUAL_UINT(1, plan.decimation);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, plan.load);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, plan.cpuLoad);
+}
+
+static void test_most_integration_time_wins() {
+  channels[0].active = true;
+  planner.setChannels(channels, OVERHEAD_US);
+  AcquisitionPlan plan;
+  TEST_ASSERT_TRUE(planner.plan(10.0f, plan));
+  // 250 SPS averaged 18 times integrates 72 ms per sample, more than any other rate fits in 85%
+  TEST_ASSERT_EQUAL_UINT(250, plan.dataRateSps);
+  TEST_ASSERT_EQUAL_UINT(18, plan.decimation);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 10.0f * 18 * stepS(250), plan.load);
+  TEST_ASSERT_TRUE(plan.load <= AcquisitionPlanner::MAX_LOAD);
+  // One more conversion per sample wouldn't have fitted
+  TEST_ASSERT_TRUE(10.0f * 19 * stepS(250) > AcquisitionPlanner::MAX_LOAD);
+}
+
+static void test_data_rate_at_the_load_cap() {
+  channels[0].active = true;
+  planner.setChannels(channels, OVERHEAD_US);
+  AcquisitionPlan plan;
+  planner.plan(1.0f, plan);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, AcquisitionPlanner::MAX_LOAD / stepS(860), plan.maxLogHz);
+
+  // Right at the ceiling only the fastest rate keeps up, with nothing left to decimate
+  float maxLogHz = plan.maxLogHz;
+  TEST_ASSERT_TRUE(planner.plan(maxLogHz, plan));
+  TEST_ASSERT_EQUAL_UINT(860, plan.dataRateSps);
+  TEST_ASSERT_EQUAL_UINT(1, plan.decimation);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, AcquisitionPlanner::MAX_LOAD, plan.load);
+
+  // Past it there's no plan, but the ceiling still comes back
+  TEST_ASSERT_FALSE(planner.plan(maxLogHz * 1.01f, plan));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, maxLogHz, plan.maxLogHz);
+}
+
+static void test_channels_on_one_adc_share_it() {
+  channels[0].active = true;
+  channels[4].active = true;  // the other ADC, in step with the first
+  planner.setChannels(channels, OVERHEAD_US);
+  AcquisitionPlan split;
+  planner.plan(1.0f, split);
+
+  channels[4].active = false;
+  channels[1].active = true;
+  planner.setChannels(channels, OVERHEAD_US);
+  AcquisitionPlan shared;
+  planner.plan(1.0f, shared);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, split.maxLogHz / 2, shared.maxLogHz);
+}
+
+static void test_own_sample_rate_is_fixed_load() {
+  channels[0].active = true;
+  channels[1].active = true;
+  channels[1].sampleRate = 100.0f;
+  planner.setChannels(channels, OVERHEAD_US);
+  AcquisitionPlan plan;
+  planner.plan(1.0f, plan);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, AcquisitionPlanner::MAX_LOAD / stepS(860) - 100.0f, plan.maxLogHz);
+
+  // Nothing follows the plan's rate, so there is no ceiling on it
+  channels[0].active = false;
+  planner.setChannels(channels, OVERHEAD_US);
+  planner.plan(1.0f, plan);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, plan.maxLogHz);
+}
+
+static void test_oversampling_caps_decimation() {
+  channels[0].active = true;
+  channels[0].oversample = 64;
+  planner.setChannels(channels, OVERHEAD_US);
+  AcquisitionPlan plan;
+  TEST_ASSERT_TRUE(planner.plan(1.0f, plan));
+  // 64 x 4 is MAX_OVERSAMPLE, so 475 SPS stops at 4 where it had room for 5
+  TEST_ASSERT_EQUAL_UINT(475, plan.dataRateSps);
+  TEST_ASSERT_EQUAL_UINT(4, plan.decimation);
+  TEST_ASSERT_TRUE(64 * 5 * stepS(475) <= AcquisitionPlanner::MAX_LOAD);
+}
+
+static void test_cpu_cap_binds_with_slow_transactions() {
+  // With long bus transactions the spinning around each one fills the core before the ADC is full
+  const uint32_t overheadUs = 5000;
+  channels[0].active = true;
+  planner.setChannels(channels, overheadUs);
+  AcquisitionPlan plan;
+  planner.plan(1.0f, plan);
+  float maxLoad = AcquisitionPlanner::MAX_CPU_LOAD * stepS(860, overheadUs) * 1e6f / (adcADS::timedSpinUsAt(860) + overheadUs);
+  TEST_ASSERT_TRUE(maxLoad < AcquisitionPlanner::MAX_LOAD);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, maxLoad / stepS(860, overheadUs), plan.maxLogHz);
+
+  TEST_ASSERT_TRUE(planner.plan(plan.maxLogHz, plan));
+  TEST_ASSERT_EQUAL_UINT(860, plan.dataRateSps);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, AcquisitionPlanner::MAX_CPU_LOAD, plan.cpuLoad);
+  TEST_ASSERT_FALSE(planner.plan(plan.maxLogHz * 1.01f, plan));
+}
+
+static void test_cpu_load_counts_the_spin() {
+  channels[0].active = true;
+  planner.setChannels(channels, OVERHEAD_US);
+  AcquisitionPlan plan;
+  TEST_ASSERT_TRUE(planner.plan(200.0f, plan));
+  // Less than the ADC load, as most of each conversion sleeps, but not free
+  float share = (adcADS::timedSpinUsAt(plan.dataRateSps) + OVERHEAD_US) / 1e6f / stepS(plan.dataRateSps);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, plan.load * share, plan.cpuLoad);
+  TEST_ASSERT_TRUE(plan.cpuLoad > 0.0f);
+  TEST_ASSERT_TRUE(plan.cpuLoad < plan.load);
+}
+
+static void test_request_is_taken_once() {
+  AcquisitionPlan plan, taken;
+  channels[0].active = true;
+  planner.setChannels(channels, OVERHEAD_US);
+  planner.plan(10.0f, plan);
+  TEST_ASSERT_FALSE(planner.takeRequest(taken));
+  planner.request(plan);
+  TEST_ASSERT_TRUE(planner.takeRequest(taken));
+  TEST_ASSERT_EQUAL_UINT(plan.dataRateSps, taken.dataRateSps);
+  TEST_ASSERT_FALSE(planner.takeRequest(taken));
+  planner.setActive(taken);
+  TEST_ASSERT_EQUAL_UINT(plan.decimation, planner.active().decimation);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_channel_set);
+  RUN_TEST(test_most_integration_time_wins);
+  RUN_TEST(test_data_rate_at_the_load_cap);
+  RUN_TEST(test_channels_on_one_adc_share_it);
+  RUN_TEST(test_own_sample_rate_is_fixed_load);
+  RUN_TEST(test_oversampling_caps_decimation);
+  RUN_TEST(test_cpu_cap_binds_with_slow_transactions);
+  RUN_TEST(test_cpu_load_counts_the_spin);
+  RUN_TEST(test_request_is_taken_once);
+  return UNITY_END();
+}
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <unity.h>
+
+#include <optional>
+
+// Built straight from source, the library folders pull in hardware-only code
+#include "adcADS.cpp"
+
+// Conversion-ready latency of adcADS against a modelled ADS1115 at 860 SPS. Time is simulated, so
+// each case measures the driver's waiting strategy rather than the host
+
+static constexpr uint16_t MUX = ADS1X15_REG_CONFIG_MUX_DIFF_0_1;
+static constexpr int8_t RDY_PIN = 39;
+static constexpr int CONVERSIONS = 100;
+
+static std::optional<adcADS> device;  // destroyed as itself, adcBase has no virtual destructor
+static adcADS *adc = nullptr;
+
+void setUp() {
+  mock::reset();
+  mock::ads = mock::Ads1115();
+  mock::notifyValue = 0;
+  adc = &device.emplace(Wire);
+  adc->init(ADS0_ADDR);
+  adc->setInputConfig(GAIN_ONE, RATE_ADS1115_860SPS);
+}
+
+void tearDown() {
+  device.reset();
+  adc = nullptr;
+}
+
+// Average start to result latency over `conversions`, each checked for the right value
+static uint32_t averageLatencyUs(int conversions) {
+  adc->resetConversionStats();
+  for (int i = 0; i < conversions; ++i) {
+    TEST_ASSERT_TRUE(adc->startConversion(MUX));
+    TEST_ASSERT_EQUAL_INT16(mock::ads.result, adc->finishConversion());
+  }
+  ConversionStats stats = adc->getConversionStats();
+  TEST_ASSERT_EQUAL_UINT32(conversions, stats.count);
+  return (uint32_t)(stats.totalUs / stats.count);
+}
+
+static void report(const char *mode, uint32_t latencyUs) {
+  char text[96];
+  snprintf(text, sizeof(text), "%s: %u us per conversion, %.0f SPS per ADC", mode, (unsigned)latencyUs, 1e6 / latencyUs);
+  TEST_MESSAGE(text);
+}
+
+void test_polling_rounds_up_to_whole_ticks() {
+  uint32_t latencyUs = averageLatencyUs(CONVERSIONS);
+  report("polled", latencyUs);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(2000, latencyUs);
+}
+
+void test_ready_interrupt_wakes_at_end_of_conversion() {
+  adc->enableReadyInterrupt(RDY_PIN, NOTIFY_ADS0_RDY);
+  uint32_t latencyUs = averageLatencyUs(CONVERSIONS);
+  report("ALERT/RDY", latencyUs);
+  TEST_ASSERT_EQUAL_UINT32(1000000 / 860, latencyUs);
+  TEST_ASSERT_EQUAL_UINT32(0, adc->getConversionStats().rdyTimeouts);
+  TEST_ASSERT_TRUE(adc->readyInterruptEnabled());
+}
+
+void test_ready_interrupt_beats_polling() {
+  uint32_t polledUs = averageLatencyUs(CONVERSIONS);
+  adc->enableReadyInterrupt(RDY_PIN, NOTIFY_ADS0_RDY);
+  uint32_t interruptUs = averageLatencyUs(CONVERSIONS);
+  TEST_ASSERT_LESS_THAN_UINT32(polledUs, interruptUs);
+}
+
+void test_timed_read_waits_out_the_worst_case() {
+  adc->setTimedRead(true);
+  uint32_t latencyUs = averageLatencyUs(CONVERSIONS);
+  report("timed", latencyUs);
+  TEST_ASSERT_EQUAL_UINT32(adc->getConversionUs(), latencyUs);
+}
+
+void test_slow_timed_read_sleeps_instead_of_spinning() {
+  adc->setInputConfig(GAIN_ONE, RATE_ADS1115_8SPS);
+  adc->setTimedRead(true);
+  uint32_t latencyUs = averageLatencyUs(4);
+  TEST_ASSERT_EQUAL_UINT32(adc->getConversionUs(), latencyUs);
+  // At most the part of a tick vTaskDelay can't resolve is spun, per conversion
+  TEST_ASSERT_LESS_THAN_UINT32(4 * portTICK_PERIOD_MS * 1000, (uint32_t)mock::busyUs);
+}
+
+void test_unwired_ready_pin_falls_back_to_timed_read() {
+  mock::ads.rdyWired = false;
+  adc->enableReadyInterrupt(RDY_PIN, NOTIFY_ADS0_RDY);
+
+  // The first misses each cost a full timeout, then the pin is given up on
+  averageLatencyUs(ADS_RDY_MAX_MISSES);
+  TEST_ASSERT_EQUAL_UINT32(ADS_RDY_MAX_MISSES, adc->getConversionStats().rdyTimeouts);
+  TEST_ASSERT_FALSE(adc->readyInterruptEnabled());
+  TEST_ASSERT_NULL(mock::isr);
+
+  uint32_t latencyUs = averageLatencyUs(CONVERSIONS);
+  TEST_ASSERT_EQUAL_UINT32(adc->getConversionUs(), latencyUs);
+  TEST_ASSERT_EQUAL_UINT32(0, adc->getConversionStats().rdyTimeouts);
+}
+
+void test_one_missed_edge_keeps_the_interrupt() {
+  adc->enableReadyInterrupt(RDY_PIN, NOTIFY_ADS0_RDY);
+  mock::ads.rdyWired = false;
+  averageLatencyUs(ADS_RDY_MAX_MISSES - 1);
+  mock::ads.rdyWired = true;
+  averageLatencyUs(CONVERSIONS);
+  TEST_ASSERT_TRUE(adc->readyInterruptEnabled());
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_polling_rounds_up_to_whole_ticks);
+  RUN_TEST(test_ready_interrupt_wakes_at_end_of_conversion);
+  RUN_TEST(test_ready_interrupt_beats_polling);
+  RUN_TEST(test_timed_read_waits_out_the_worst_case);
+  RUN_TEST(test_slow_timed_read_sleeps_instead_of_spinning);
+  RUN_TEST(test_unwired_ready_pin_falls_back_to_timed_read);
+  RUN_TEST(test_one_missed_edge_keeps_the_interrupt);
+  return UNITY_END();
+}
@@ -0,0 +1,115 @@
+#include <unity.h>
+
+#include "CalibrationCurve.cpp"
+
+// CalibrationCurve tables on the 33-entry grid, and polynomials by Horner's rule
+
+static CalibrationCurve curve;
+
+void setUp() { curve = CalibrationCurve(); }
+
+void tearDown() {}
+
+static void test_table_through_grid_points() {
+  // 0, 1 and 2 V all land on the grid (step 1/16 V), so the table passes through them exactly
+  const CalibrationPoint points[] = {{0.0f, 0.0f}, {1.0f, 10.0f}, {2.0f, 40.0f}};
+  TEST_ASSERT_TRUE(curve.compileTable(points, 3));
+  TEST_ASSERT_TRUE(curve.active());
+  TEST_ASSERT_TRUE(curve.kind() == CalibrationCurve::Kind::TABLE);
+  // Both ends and the midpoint
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.0f, curve.evaluate(0.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 40.0f, curve.evaluate(2.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 10.0f, curve.evaluate(1.0f));
+  // Linear between the points
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 5.0f, curve.evaluate(0.5f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 25.0f, curve.evaluate(1.5f));
+}
+
+static void test_table_extrapolates_the_end_cells() {
+  const CalibrationPoint points[] = {{0.0f, 0.0f}, {1.0f, 10.0f}, {2.0f, 40.0f}};
+  TEST_ASSERT_TRUE(curve.compileTable(points, 3));
+  // Along the first segment's slope below, the last one's above
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, -10.0f, curve.evaluate(-1.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 70.0f, curve.evaluate(3.0f));
+}
+
+static void test_table_points_in_any_order() {
+  const CalibrationPoint points[] = {{0.02f, 200.0f}, {-0.01f, -100.0f}, {0.0f, 0.0f}};
+  TEST_ASSERT_TRUE(curve.compileTable(points, 3));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, -100.0f, curve.evaluate(-0.01f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.0f, curve.evaluate(0.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 200.0f, curve.evaluate(0.02f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 100.0f, curve.evaluate(0.01f));
+}
+
+static void test_table_off_grid_point() {
+  // 0.3 V falls between grid entries, so the bend there is cut across by at most one cell
+  const CalibrationPoint points[] = {{0.0f, 0.0f}, {0.3f, 3.0f}, {1.0f, 4.0f}};
+  TEST_ASSERT_TRUE(curve.compileTable(points, 3));
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 3.0f, curve.evaluate(0.3f));
+  // Away from the bend it's exact again
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 1.0f, curve.evaluate(0.1f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 4.0f, curve.evaluate(1.0f));
+}
+
+static void test_bad_tables_are_rejected() {
+  const CalibrationPoint one[] = {{0.0f, 0.0f}};
+  TEST_ASSERT_FALSE(curve.compileTable(one, 1));
+  const CalibrationPoint twice[] = {{0.0f, 0.0f}, {1.0f, 1.0f}, {1.0f, 2.0f}};
+  TEST_ASSERT_FALSE(curve.compileTable(twice, 3));
+  CalibrationPoint many[CalibrationCurve::MAX_POINTS + 1];
+  for (size_t i = 0; i < CalibrationCurve::MAX_POINTS + 1; ++i) many[i] = {(float)i, (float)i};
+  TEST_ASSERT_FALSE(curve.compileTable(many, CalibrationCurve::MAX_POINTS + 1));
+  TEST_ASSERT_TRUE(curve.compileTable(many, CalibrationCurve::MAX_POINTS));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 7.5f, curve.evaluate(7.5f));
+  TEST_ASSERT_TRUE(curve.active());
+}
+
+static void test_polynomial_horner() {
+  // 1 + 2v + 3v^2
+  const float quadratic[] = {1.0f, 2.0f, 3.0f};
+  TEST_ASSERT_TRUE(curve.compilePolynomial(quadratic, 3));
+  TEST_ASSERT_TRUE(curve.kind() == CalibrationCurve::Kind::POLYNOMIAL);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 1.0f, curve.evaluate(0.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 17.0f, curve.evaluate(2.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 2.0f, curve.evaluate(-1.0f));
+
+  // v^5 at the highest order allowed
+  const float quintic[] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+  TEST_ASSERT_TRUE(curve.compilePolynomial(quintic, 6));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 32.0f, curve.evaluate(2.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, -243.0f, curve.evaluate(-3.0f));
+
+  // A constant
+  const float constant[] = {7.0f};
+  TEST_ASSERT_TRUE(curve.compilePolynomial(constant, 1));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 7.0f, curve.evaluate(123.0f));
+}
+
+static void test_bad_polynomials_are_rejected() {
+  const float coeffs[CalibrationCurve::MAX_TERMS + 1] = {};
+  TEST_ASSERT_FALSE(curve.compilePolynomial(coeffs, 0));
+  TEST_ASSERT_FALSE(curve.compilePolynomial(coeffs, CalibrationCurve::MAX_TERMS + 1));
+  TEST_ASSERT_FALSE(curve.active());
+}
+
+static void test_clear_goes_back_to_linear() {
+  const float coeffs[] = {1.0f, 2.0f};
+  TEST_ASSERT_TRUE(curve.compilePolynomial(coeffs, 2));
+  curve.clear();
+  TEST_ASSERT_FALSE(curve.active());
+  TEST_ASSERT_TRUE(curve.kind() == CalibrationCurve::Kind::LINEAR);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_table_through_grid_points);
+  RUN_TEST(test_table_extrapolates_the_end_cells);
+  RUN_TEST(test_table_points_in_any_order);
+  RUN_TEST(test_table_off_grid_point);
+  RUN_TEST(test_bad_tables_are_rejected);
+  RUN_TEST(test_polynomial_horner);
+  RUN_TEST(test_bad_polynomials_are_rejected);
+  RUN_TEST(test_clear_goes_back_to_linear);
+  return UNITY_END();
+}
@@ -0,0 +1,158 @@
+#include <string>
+#include <unity.h>
+
+#include "DerivedChannels.cpp"
+
+// DerivedChannels compiler and evaluator: precedence, bad expressions, stack limits and the time operators
+
+static DerivedChannels derived;
+static float units[8];
+static float out[DerivedChannels::MAX_CHANNELS];
+
+void setUp() {
+  derived.clear();
+  for (int i = 0; i < 8; ++i) units[i] = (float)(i + 1);  // CHn reads n
+  for (float &v : out) v = 0.0f;
+}
+
+void tearDown() {}
+
+// Compile `expression` alone and return its value on `units`
+static float eval(const char *expression) {
+  derived.clear();
+  TEST_ASSERT_TRUE(derived.add(expression));
+  derived.evaluate(units, 0.1f, out);
+  return out[0];
+}
+
+static void test_precedence() {
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 7.0f, eval("1 + 2 * 3"));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 9.0f, eval("(1 + 2) * 3"));
+  // Left to right within a level
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 3.0f, eval("10 - 4 - 3"));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f, eval("8 / 4 / 2"));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 14.0f, eval("CH2 + CH3 * CH4"));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 2.5f, eval("0.5 * ch5"));
+}
+
+static void test_unary_minus() {
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, -6.0f, eval("-CH3 * 2"));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, -6.0f, eval("2 * -3"));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 4.0f, eval("--4"));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, -3.0f, eval("-(1 + 2)"));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 3.0f, eval("1 - -(CH1 + 1)"));
+}
+
+static void test_derived_channels_chain() {
+  TEST_ASSERT_TRUE(derived.add("CH1 + CH2"));
+  TEST_ASSERT_TRUE(derived.add("D1 * 10"));
+  TEST_ASSERT_EQUAL_UINT(2, derived.size());
+  TEST_ASSERT_EQUAL_UINT8(0x03, derived.inputMask());
+  derived.evaluate(units, 0.1f, out);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 3.0f, out[0]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 30.0f, out[1]);
+}
+
+static void test_unknown_identifiers_are_rejected() {
+  const char *bad[] = {"CH0", "CH9", "CH", "X1", "D1", "foo(CH1)", "integ(CH1)", "CH1x", "pi"};
+  for (const char *expression : bad) {
+    TEST_MESSAGE(expression);
+    TEST_ASSERT_FALSE(derived.add(expression));
+  }
+  // A channel may only refer to the ones before it
+  TEST_ASSERT_TRUE(derived.add("CH1"));
+  TEST_ASSERT_FALSE(derived.add("D2"));
+  TEST_ASSERT_EQUAL_UINT(1, derived.size());
+}
+
+static void test_malformed_expressions_are_rejected() {
+  const char *bad[] = {"", "   ", "1 +", "(1", "1)", "1 2", "* 2", ")", "()", "CH1 CH2", "integral CH1", "integral(CH1", "1 + * 2", "-"};
+  for (const char *expression : bad) {
+    TEST_MESSAGE(expression);
+    TEST_ASSERT_FALSE(derived.add(expression));
+  }
+  // Nothing was left behind by the failures
+  TEST_ASSERT_EQUAL_UINT(0, derived.size());
+  TEST_ASSERT_EQUAL_UINT8(0, derived.inputMask());
+  TEST_ASSERT_TRUE(derived.add("CH8"));
+  derived.evaluate(units, 0.1f, out);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 8.0f, out[0]);
+}
+
+static void test_stack_overflow_is_rejected() {
+  // Right-nested sums need one stack slot per level
+  std::string fits = "1";
+  for (size_t i = 1; i < DerivedChannels::MAX_STACK; ++i) fits = "1 + (" + fits + ")";
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, (float)DerivedChannels::MAX_STACK, eval(fits.c_str()));
+
+  derived.clear();
+  std::string deep = "1 + (" + fits + ")";
+  TEST_ASSERT_FALSE(derived.add(deep.c_str()));
+  TEST_ASSERT_EQUAL_UINT(0, derived.size());
+}
+
+static void test_deep_nesting_is_rejected() {
+  // Bounded before it can run the parser off the end of the task's stack
+  std::string brackets = std::string(10000, '(') + "1" + std::string(10000, ')');
+  TEST_ASSERT_FALSE(derived.add(brackets.c_str()));
+  std::string minuses = std::string(10000, '-') + "1";
+  TEST_ASSERT_FALSE(derived.add(minuses.c_str()));
+  // Brackets alone don't use the stack, so a few levels are fine
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 2.0f, eval("((((CH2))))"));
+}
+
+static void test_program_overflow_is_rejected() {
+  std::string longSum = "CH1";
+  for (size_t i = 0; i < DerivedChannels::MAX_PROGRAM; ++i) longSum += " + 1";
+  TEST_ASSERT_FALSE(derived.add(longSum.c_str()));
+  TEST_ASSERT_EQUAL_UINT(0, derived.size());
+}
+
+static void test_channel_count_is_capped() {
+  for (size_t i = 0; i < DerivedChannels::MAX_CHANNELS; ++i) TEST_ASSERT_TRUE(derived.add("CH1"));
+  TEST_ASSERT_FALSE(derived.add("CH1"));
+}
+
+static void test_division_by_zero_gives_zero() {
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, eval("CH1 / 0"));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, eval("CH1 / (CH2 - 2)"));
+  // And the rest of the expression carries on from there
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 5.0f, eval("CH1 / 0 + 5"));
+}
+
+static void test_integral_and_derivative() {
+  TEST_ASSERT_TRUE(derived.add("integral(CH2)"));
+  TEST_ASSERT_TRUE(derived.add("derivative(CH1 * 10)"));
+  // The first call only primes them
+  derived.evaluate(units, 0.1f, out);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, out[0]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, out[1]);
+  for (int i = 0; i < 10; ++i) {
+    units[0] += 0.5f;
+    derived.evaluate(units, 0.1f, out);
+  }
+  // 2 for 1 s, and CH1 * 10 rising 50 per 0.1 s
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 2.0f, out[0]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 50.0f, out[1]);
+
+  derived.reset();
+  derived.evaluate(units, 0.1f, out);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, out[0]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, out[1]);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_precedence);
+  RUN_TEST(test_unary_minus);
+  RUN_TEST(test_derived_channels_chain);
+  RUN_TEST(test_unknown_identifiers_are_rejected);
+  RUN_TEST(test_malformed_expressions_are_rejected);
+  RUN_TEST(test_stack_overflow_is_rejected);
+  RUN_TEST(test_deep_nesting_is_rejected);
+  RUN_TEST(test_program_overflow_is_rejected);
+  RUN_TEST(test_channel_count_is_capped);
+  RUN_TEST(test_division_by_zero_gives_zero);
+  RUN_TEST(test_integral_and_derivative);
+  return UNITY_END();
+}
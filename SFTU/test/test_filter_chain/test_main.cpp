@@ -0,0 +1,122 @@
+#include <math.h>
+#include <unity.h>
+
+#include "FilterChain.cpp"
+
+// FilterChain against the RBJ cookbook, the moving average window, and priming from the first sample
+
+static constexpr float RATE_HZ = 1000.0f;
+
+static FilterChain chain;
+
+void setUp() {
+  chain.clear();
+  chain.setSampleRate(RATE_HZ);
+}
+
+void tearDown() {}
+
+// Lowpass at 100 Hz, Q 0.7071, 1 kHz, from the cookbook formulas in double precision
+static const float LOWPASS_IMPULSE[] = {0.067455f, 0.212010f, 0.281932f, 0.234725f, 0.151904f, 0.076729f};
+static const float LOWPASS_STEP[] = {0.067455f, 0.279465f, 0.561397f, 0.796122f, 0.948026f, 1.024756f};
+
+static void test_lowpass_impulse_response() {
+  TEST_ASSERT_TRUE(chain.addStage(FilterType::LOWPASS, 100.0f, 0.7071f, 0));
+  // A zero first sample primes the state at rest
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, chain.process(0.0f));
+  for (size_t i = 0; i < sizeof(LOWPASS_IMPULSE) / sizeof(LOWPASS_IMPULSE[0]); ++i) {
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, LOWPASS_IMPULSE[i], chain.process(i == 0 ? 1.0f : 0.0f));
+  }
+}
+
+static void test_lowpass_step_response() {
+  TEST_ASSERT_TRUE(chain.addStage(FilterType::LOWPASS, 100.0f, 0.7071f, 0));
+  chain.process(0.0f);
+  for (size_t i = 0; i < sizeof(LOWPASS_STEP) / sizeof(LOWPASS_STEP[0]); ++i) {
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, LOWPASS_STEP[i], chain.process(1.0f));
+  }
+  // Unity DC gain once it has settled
+  float y = 0.0f;
+  for (int i = 0; i < 200; ++i) y = chain.process(1.0f);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 1.0f, y);
+}
+
+static void test_notch_nulls_its_frequency() {
+  TEST_ASSERT_TRUE(chain.addStage(FilterType::NOTCH, 50.0f, 5.0f, 0));
+  float peak = 0.0f;
+  for (int i = 0; i < 2000; ++i) {
+    float y = chain.process(100.0f + 10.0f * sinf(2.0f * PI * 50.0f * i / RATE_HZ));
+    // Skip the settling, then the 50 Hz is gone and the offset passes through
+    if (i >= 1000) peak = fmaxf(peak, fabsf(y - 100.0f));
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.0f, peak);
+}
+
+static void test_moving_average_window() {
+  TEST_ASSERT_TRUE(chain.addStage(FilterType::MOVING_AVERAGE, 0.0f, 0.0f, 4));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, chain.process(0.0f));
+  // Window of 4: 1, 2, 3, 4 ramp in over a primed window of zeros
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.25f, chain.process(1.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.75f, chain.process(2.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.5f, chain.process(3.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 2.5f, chain.process(4.0f));
+  // Past the sum rebuild, the oldest sample drops out
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 3.5f, chain.process(5.0f));
+}
+
+static void test_moving_average_length_is_clamped() {
+  TEST_ASSERT_TRUE(chain.addStage(FilterType::MOVING_AVERAGE, 0.0f, 0.0f, 0));
+  chain.process(0.0f);
+  // Length 0 becomes 1, a pass-through
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 7.0f, chain.process(7.0f));
+}
+
+static void test_first_sample_primes_the_chain() {
+  TEST_ASSERT_TRUE(chain.addStage(FilterType::NOTCH, 50.0f, 5.0f, 0));
+  TEST_ASSERT_TRUE(chain.addStage(FilterType::LOWPASS, 20.0f, 0.7071f, 0));
+  TEST_ASSERT_TRUE(chain.addStage(FilterType::MOVING_AVERAGE, 0.0f, 0.0f, 16));
+  // No ramp up from zero at the start
+  for (int i = 0; i < 50; ++i) TEST_ASSERT_FLOAT_WITHIN(0.01f, 1234.0f, chain.process(1234.0f));
+
+  // Nor after a reset, at the new level
+  chain.reset();
+  for (int i = 0; i < 50; ++i) TEST_ASSERT_FLOAT_WITHIN(0.01f, -500.0f, chain.process(-500.0f));
+}
+
+static void test_rate_change_keeps_the_level() {
+  TEST_ASSERT_TRUE(chain.addStage(FilterType::LOWPASS, 20.0f, 0.7071f, 0));
+  for (int i = 0; i < 10; ++i) chain.process(300.0f);
+  chain.setSampleRate(2 * RATE_HZ);
+  for (int i = 0; i < 50; ++i) TEST_ASSERT_FLOAT_WITHIN(0.05f, 300.0f, chain.process(300.0f));
+}
+
+static void test_corner_above_nyquist_passes_through() {
+  TEST_ASSERT_TRUE(chain.addStage(FilterType::LOWPASS, 600.0f, 0.7071f, 0));
+  chain.process(0.0f);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f, chain.process(1.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, -2.0f, chain.process(-2.0f));
+}
+
+static void test_chain_is_capped() {
+  for (size_t i = 0; i < FilterChain::MAX_STAGES; ++i) {
+    TEST_ASSERT_TRUE(chain.addStage(FilterType::MOVING_AVERAGE, 0.0f, 0.0f, 2));
+  }
+  TEST_ASSERT_FALSE(chain.addStage(FilterType::LOWPASS, 10.0f, 0.7071f, 0));
+  TEST_ASSERT_EQUAL_UINT(FilterChain::MAX_STAGES, chain.numStages());
+  chain.process(1.0f);
+  TEST_ASSERT_EQUAL_UINT32(1, chain.getStageStats(0).count);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_lowpass_impulse_response);
+  RUN_TEST(test_lowpass_step_response);
+  RUN_TEST(test_notch_nulls_its_frequency);
+  RUN_TEST(test_moving_average_window);
+  RUN_TEST(test_moving_average_length_is_clamped);
+  RUN_TEST(test_first_sample_primes_the_chain);
+  RUN_TEST(test_rate_change_keeps_the_level);
+  RUN_TEST(test_corner_above_nyquist_passes_through);
+  RUN_TEST(test_chain_is_capped);
+  return UNITY_END();
+}
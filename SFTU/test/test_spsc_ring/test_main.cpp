@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <unity.h>
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "SpscRing.hpp"
+
+// SpscRing edge cases, and ns/sample against the queue it replaced
+
+static constexpr size_t CAPACITY = 16;
+
+// Same size as the SampleWithTimestamp the FreeRTOS queue used to carry
+struct Record {
+  uint64_t timestamp;
+  int32_t values[8];
+};
+static_assert(sizeof(Record) == 40, "queue item was 40 bytes");
+
+static SpscRing ring;
+
+void setUp() {
+  mock::notifyGives = 0;
+  TEST_ASSERT_TRUE(ring.begin(CAPACITY, sizeof(Record)));
+}
+
+void tearDown() { ring.end(); }
+
+static bool push(uint64_t timestamp) {
+  uint8_t *slot = ring.reserve();
+  if (slot == nullptr) return false;
+  reinterpret_cast<Record *>(slot)->timestamp = timestamp;
+  ring.commit();
+  return true;
+}
+
+// Drain everything, checking the records come out in order from `first`. Returns how many there were
+static size_t drain(uint64_t first) {
+  size_t total = 0;
+  const uint8_t *span = nullptr;
+  size_t count;
+  while ((count = ring.peek(&span)) > 0) {
+    for (size_t i = 0; i < count; ++i) TEST_ASSERT_EQUAL_UINT32(first + total + i, reinterpret_cast<const Record *>(span)[i].timestamp);
+    ring.release(count);
+    total += count;
+  }
+  return total;
+}
+
+void test_rejects_capacity_that_isnt_a_power_of_two() {
+  SpscRing other;
+  TEST_ASSERT_FALSE(other.begin(12, sizeof(Record)));
+  TEST_ASSERT_FALSE(other.begin(0, sizeof(Record)));
+}
+
+void test_empty_ring_has_nothing_to_peek() {
+  const uint8_t *span = nullptr;
+  TEST_ASSERT_EQUAL_UINT32(0, ring.peek(&span));
+  TEST_ASSERT_EQUAL_UINT32(0, ring.size());
+}
+
+void test_full_ring_drops_and_counts() {
+  for (uint64_t i = 0; i < CAPACITY; ++i) TEST_ASSERT_TRUE(push(i));
+  TEST_ASSERT_FALSE(push(CAPACITY));
+  TEST_ASSERT_FALSE(push(CAPACITY + 1));
+  TEST_ASSERT_EQUAL_UINT32(2, ring.dropped());
+  TEST_ASSERT_EQUAL_UINT32(CAPACITY, ring.highWater());
+  TEST_ASSERT_EQUAL_UINT32(CAPACITY, drain(0));
+  TEST_ASSERT_TRUE(push(CAPACITY));
+}
+
+void test_wraparound_splits_into_two_spans() {
+  for (uint64_t i = 0; i < 10; ++i) push(i);
+  TEST_ASSERT_EQUAL_UINT32(10, drain(0));
+
+  // Tail sits at slot 10, so 16 records run 6 to the end of the buffer and 10 from the start
+  for (uint64_t i = 10; i < 26; ++i) TEST_ASSERT_TRUE(push(i));
+  const uint8_t *span = nullptr;
+  TEST_ASSERT_EQUAL_UINT32(6, ring.peek(&span));
+  ring.release(6);
+  TEST_ASSERT_EQUAL_UINT32(10, ring.peek(&span));
+  TEST_ASSERT_EQUAL_UINT32(16, reinterpret_cast<const Record *>(span)->timestamp);
+  TEST_ASSERT_EQUAL_UINT32(10, drain(16));
+}
+
+void test_at_looks_past_the_wrap() {
+  for (uint64_t i = 0; i < 12; ++i) push(i);
+  drain(0);
+  for (uint64_t i = 12; i < 20; ++i) push(i);
+  for (size_t i = 0; i < ring.size(); ++i) TEST_ASSERT_EQUAL_UINT32(12 + i, reinterpret_cast<const Record *>(ring.at(i))->timestamp);
+}
+
+void test_watermark_notifies_once_until_peeked() {
+  ring.setConsumer(mock::currentTask, 4);
+  for (uint64_t i = 0; i < 3; ++i) push(i);
+  TEST_ASSERT_EQUAL_UINT32(0, mock::notifyGives);
+  push(3);
+  push(4);
+  TEST_ASSERT_EQUAL_UINT32(1, mock::notifyGives);
+  drain(0);
+  for (uint64_t i = 5; i < 9; ++i) push(i);
+  TEST_ASSERT_EQUAL_UINT32(2, mock::notifyGives);
+}
+
+// Stand-in for xQueueSend / xQueueReceive: a lock around every call and a copy in and out, which is
+// what the FreeRTOS queue costs on top of the storage
+class CopyQueue {
+ public:
+  explicit CopyQueue(size_t capacity) : m_items(capacity) {}
+  bool send(const Record &item) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (m_count == m_items.size()) return false;
+    memcpy(&m_items[(m_head + m_count) % m_items.size()], &item, sizeof(Record));
+    m_count++;
+    return true;
+  }
+  bool receive(Record &item) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (m_count == 0) return false;
+    memcpy(&item, &m_items[m_head], sizeof(Record));
+    m_head = (m_head + 1) % m_items.size();
+    m_count--;
+    return true;
+  }
+
+ private:
+  std::mutex m_lock;
+  std::vector<Record> m_items;
+  size_t m_head = 0;
+  size_t m_count = 0;
+};
+
+void test_benchmark_against_the_queue() {
+  using Clock = std::chrono::steady_clock;
+  constexpr size_t SIZE = 512, BATCH = 256, SAMPLES = 4'000'000;
+  volatile uint64_t sink = 0;
+
+  // Producer fills a batch, consumer takes it, as the analog and SD tasks do around the watermark
+  SpscRing bench;
+  TEST_ASSERT_TRUE(bench.begin(SIZE, sizeof(Record)));
+  auto start = Clock::now();
+  for (size_t done = 0; done < SAMPLES; done += BATCH) {
+    for (size_t i = 0; i < BATCH; ++i) {
+      Record *slot = reinterpret_cast<Record *>(bench.reserve());
+      slot->timestamp = done + i;
+      slot->values[0] = (int32_t)i;
+      bench.commit();
+    }
+    const uint8_t *span = nullptr;
+    size_t count;
+    while ((count = bench.peek(&span)) > 0) {
+      for (size_t i = 0; i < count; ++i) sink = sink + reinterpret_cast<const Record *>(span)[i].timestamp;
+      bench.release(count);
+    }
+  }
+  double ringNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / SAMPLES;
+
+  CopyQueue queue(SIZE);
+  start = Clock::now();
+  for (size_t done = 0; done < SAMPLES; done += BATCH) {
+    for (size_t i = 0; i < BATCH; ++i) {
+      Record item = {};
+      item.timestamp = done + i;
+      item.values[0] = (int32_t)i;
+      queue.send(item);
+    }
+    Record item;
+    while (queue.receive(item)) sink = sink + item.timestamp;
+  }
+  double queueNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / SAMPLES;
+
+  char text[96];
+  snprintf(text, sizeof(text), "ring %.1f ns/sample, locked copy queue %.1f ns/sample", ringNs, queueNs);
+  TEST_MESSAGE(text);
+  TEST_ASSERT_EQUAL_UINT32(0, bench.dropped());
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_rejects_capacity_that_isnt_a_power_of_two);
+  RUN_TEST(test_empty_ring_has_nothing_to_peek);
+  RUN_TEST(test_full_ring_drops_and_counts);
+  RUN_TEST(test_wraparound_splits_into_two_spans);
+  RUN_TEST(test_at_looks_past_the_wrap);
+  RUN_TEST(test_watermark_notifies_once_until_peeked);
+  RUN_TEST(test_benchmark_against_the_queue);
+  return UNITY_END();
+}
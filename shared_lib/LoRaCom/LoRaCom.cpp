@@ -214,7 +214,7 @@ void LoRaCom::processSendQueue() {
 
     if ((q.retryCount == 0) || (millis() - q.lastSendTime >= ACK_TIMEOUT_MS)) {
       if (q.retryCount < MAX_RETRIES) {
-        sendMessage(reinterpret_cast<const uint8_t *>(&q.msg), sizeof(LoRaMessage), TX_TIMEOUT_MS, idx);
+        sendMessage(reinterpret_cast<const uint8_t *>(&q.msg), messageSize(q.msg), TX_TIMEOUT_MS, idx);
         q.lastSendTime = millis();
         q.retryCount++;
         ESP_LOGI(TAG, "Retrying command message (seq %u), attempt %u", q.msg.sequenceID, q.retryCount);
@@ -231,7 +231,7 @@ void LoRaCom::processSendQueue() {
     uint8_t idx = (sendHead + i) % MAX_QUEUE_SIZE;
     QueuedMessage &q = sendQueue[idx];
     if (q.acknowledged || q.reqAck) continue;
-    sendMessage(reinterpret_cast<const uint8_t *>(&q.msg), sizeof(LoRaMessage), TX_TIMEOUT_MS, idx);
+    sendMessage(reinterpret_cast<const uint8_t *>(&q.msg), messageSize(q.msg), TX_TIMEOUT_MS, idx);
     ESP_LOGI(TAG, "Transmitting message (seq %u) with no ACK required", q.msg.sequenceID);
   }
 }
@@ -260,6 +260,7 @@ bool LoRaCom::receiveMessage(LoRaMessage *msg) {
 
     switch (msg->type) {
       case TYPE_COMMAND:
+      case TYPE_BURN:  // sent once per sequence, so it's acked like a command
         // parse and respond
         sendAck(msg->senderID, msg->sequenceID);
         break;
@@ -288,7 +289,7 @@ void LoRaCom::sendAck(uint8_t targetID, uint8_t seqID) {
   msg.length = sizeof(ack);
   memcpy(msg.payload, &ack, sizeof(ack));
 
-  sendMessage(reinterpret_cast<const uint8_t *>(&msg), sizeof(LoRaMessage), TX_TIMEOUT_MS, -1);
+  sendMessage(reinterpret_cast<const uint8_t *>(&msg), messageSize(msg), TX_TIMEOUT_MS, -1);
 
   ESP_LOGI(TAG, "Sent ACK for sequence ID: %u to target ID: %u", seqID, targetID);
 }
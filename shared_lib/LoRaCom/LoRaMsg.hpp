@@ -21,20 +21,32 @@ struct LoRaMessage {
   uint8_t payload[MAX_PAYLOAD_SIZE];
 };
 
+// Bytes on air, the header and as much of the payload as `length` says is used
+inline size_t messageSize(const LoRaMessage &msg) { return offsetof(LoRaMessage, payload) + std::min<size_t>(msg.length, MAX_PAYLOAD_SIZE); }
+
+// One channel over the status interval, in its units
+struct ChannelSummary {
+  float min;
+  float max;
+  float mean;
+  float rms;
+};
+
+// Fixed start of a status message. It is followed by a ChannelSummary for each channel in channelMask,
+// lowest first, then float derived[numDerived], and the message length only covers what is there
 struct StatusPayload {
   int8_t rssi;
   float batteryVoltage;
-  uint8_t status;  // e.g. enum or code
-  float IN1;
-  float IN2;
-  float IN3;
-  float IN4;
-  float IN5;
-  float IN6;
-  float IN7;
-  float IN8;
+  uint8_t status;       // e.g. enum or code
+  uint8_t channelMask;  // channels with a summary
+  uint16_t windowMs;    // time the summaries cover, 0 when they hold the latest value only
+  uint8_t numDerived;   // derived values after the summaries
 };
 
+static constexpr size_t MAX_STATUS_DERIVED = 4;
+
+inline size_t statusPayloadSize(uint8_t channelMask, uint8_t numDerived) { return sizeof(StatusPayload) + __builtin_popcount(channelMask) * sizeof(ChannelSummary) + numDerived * sizeof(float); }
+
 struct CommandPayload {
   uint8_t commandID;
   uint8_t paramType;  // 0 = float, 1 = string
@@ -47,6 +59,23 @@ struct CommandPayload {
 struct AckPayload {
   uint8_t acknowledgedSequenceID;
 };
+
+// Sent once a sequence finishes or is stopped, worked out on the SFTU while it ran
+struct BurnPayload {
+  uint8_t flags;      // burnFlags
+  float sequenceS;    // sequence start to end
+  float burnTimeS;    // thrust first to last above the threshold
+  float peakThrust;   // in the thrust channel's units
+  float peakThrustTimeS;  // after ignition
+  float totalImpulse;     // thrust units x s
+  float averageThrust;
+  float peakPressure;  // over the whole sequence, valid with BURN_PRESSURE
+};
+
+// Free-form reply to a command, null terminated
+struct TextPayload {
+  char text[MAX_PAYLOAD_SIZE];
+};
 #pragma pack(pop)
 
 struct QueuedMessage {
@@ -62,6 +91,15 @@ enum messageType {
   TYPE_STATUS = 0,
   TYPE_COMMAND = 1,
   TYPE_ACK = 2,
+  TYPE_TEXT = 3,
+  TYPE_BURN = 4,
+};
+
+enum burnFlags {
+  BURN_DETECTED = 1 << 0,   // thrust crossed the threshold, the burn fields are valid
+  BURN_STOPPED = 1 << 1,    // sequence was stopped or E-stopped
+  BURN_CUT_SHORT = 1 << 2,  // still above the threshold when tracking ended
+  BURN_PRESSURE = 1 << 3,
 };
 
 enum deviceStatus {
@@ -25,4 +25,16 @@ enum CommandID {
 
   CMD_SEQ = 15,
 
+  CMD_TIMING_STATS = 16,
+
+  CMD_BURST = 17,
+
+  CMD_CALIBRATION = 18,
+
+  CMD_SPECTRUM = 19,
+
+  CMD_SAMPLE_RATE = 20,
+
+  CMD_RELOAD_CONFIG = 21,
+
 };
\ No newline at end of file
@@ -1,7 +1,7 @@
 #include "commander.hpp"
 
 #ifdef SFTU
-Commander::Commander(SerialCom *serialCom, LoRaCom *loraCom, Actuation *actuation, adcADS *adcADS, adcProcessor *adcProcessors[8]) {
+Commander::Commander(SerialCom *serialCom, LoRaCom *loraCom, Actuation *actuation, adcADS *adcADS, adcProcessor *adcProcessors[8], SampleClock *sampleClock, BurstCapture *burstCapture, CalibrationCapture *calCapture, SpectrumAnalyzer *spectrum, AcquisitionPlanner *planner, ConfigReload *configReload, BurnMonitor *burnMonitor) {
   memset(m_command, 0, sizeof(m_command));
   m_serialCom = serialCom;
   m_loraCom = loraCom;
@@ -9,6 +9,38 @@ Commander::Commander(SerialCom *serialCom, LoRaCom *loraCom, Actuation *actuatio
   m_outputSequencer = new outputSequencer(actuation);  // Initialize output sequencer
   m_adcADS = adcADS;
   m_adcProcessors = adcProcessors;  // Initialize the adcProcessors array
+  m_sampleClock = sampleClock;
+  m_burstCapture = burstCapture;
+  m_calCapture = calCapture;
+  m_spectrum = spectrum;
+  m_planner = planner;
+  m_configReload = configReload;
+  m_burnMonitor = burnMonitor;
+
+  // Sequence starts and E-stops freeze the burst capture around the event, and each sequence gets a burn summary
+  m_outputSequencer->setEventHooks(
+      [](void *arg) {
+        Commander *commander = static_cast<Commander *>(arg);
+        if (commander->m_burstCapture) commander->m_burstCapture->trigger(BurstTrigger::SEQUENCE);
+        if (commander->m_burnMonitor) commander->m_burnMonitor->start();
+      },
+      [](void *arg) {
+        Commander *commander = static_cast<Commander *>(arg);
+        if (commander->m_burstCapture) commander->m_burstCapture->trigger(BurstTrigger::ESTOP);
+      },
+      [](bool stopped, void *arg) {
+        Commander *commander = static_cast<Commander *>(arg);
+        if (commander->m_burnMonitor) commander->m_burnMonitor->end(stopped);
+      },
+      this);
+  // Spectra finish on the analyser's own task, long after the command returned
+  if (m_spectrum) {
+    m_spectrum->setResultHandler([](const char *text, void *arg) { static_cast<Commander *>(arg)->reply(text); }, this);
+  }
+  // Likewise a reload is done by the SD task once the new channels are live
+  if (m_configReload) {
+    m_configReload->setResultHandler([](const char *text, void *arg) { static_cast<Commander *>(arg)->reply(text); }, this);
+  }
   ESP_LOGD(TAG, "Commander initialised");
 }
 
@@ -57,8 +89,39 @@ Commander::Commander(SerialCom *serialCom, LoRaCom *loraCom) {
 }
 #endif
 
+void Commander::reply(const char *text) {
+  m_serialCom->sendData(text);
+  m_serialCom->sendData("\n");
+
+  LoRaMessage msg;
+  msg.senderID = DEVICE_ID;
+  msg.receiverID = BROADCAST_ID;
+  msg.type = TYPE_TEXT;
+  TextPayload payload;
+  strncpy(payload.text, text, sizeof(payload.text) - 1);
+  payload.text[sizeof(payload.text) - 1] = '\0';
+  msg.length = strlen(payload.text) + 1;
+  memcpy(msg.payload, &payload, msg.length);
+  m_loraCom->enqueueMessage(msg, false);
+}
+
 void Commander::handle_command_help() {
   handle_help(command_handler);  // Call the generic help handler
+
+  // Commands sent by ID from the GUI or over LoRa, see commandID.hpp
+  ESP_LOGI(TAG,
+           "\nCommand IDs <id> <param>:\n"
+           "- 4 gain, 5 freqMHz, 7 sf, 8 bwKHz: LoRa radio settings\n"
+           "- 11 <kg>: calibrate CH1 to a mass, 14 <units/V>: CH1 scale\n"
+           "- 12 <output.state>: set an output, e.g. 3.1 turns output 3 on\n"
+           "- 13: hard reset\n"
+           "- 15 <create UID CH:STATE:MS;...|run UID|stop>: output sequences\n"
+           "- 16 <0|1>: sample timing stats, 1 also clears them\n"
+           "- 17 <0|1>: burst capture state, 1 also triggers a capture\n"
+           "- 18 <tare CH [N]|calibrate CH UNITS [N]|scale CH UNITS_PER_V|point CH UNITS [N]|apply CH|list CH|clear CH>: calibration\n"
+           "- 19 <CH [LENGTH]>: noise spectrum of a channel, LENGTH a power of two\n"
+           "- 20 <Hz>: log rate for channels without their own sample_rate, 0 reports the plan\n"
+           "- 21: reload config.json without stopping acquisition");
 }
 
 void Commander::handle_update_help() {
@@ -278,6 +341,12 @@ bool Commander::runCommand(uint8_t commandID, const char *param) {
     case CMD_SEQ:
       handle_seq(param);
       break;
+    case CMD_CALIBRATION:
+      handle_calibration(param);
+      break;
+    case CMD_SPECTRUM:
+      handle_spectrum(param);
+      break;
     default:
       return false;
   }
@@ -309,6 +378,18 @@ bool Commander::runCommand(uint8_t commandID, float param) {
     case CMD_SET_OUTPUT:
       handle_set_OUTPUT(param);
       break;
+    case CMD_TIMING_STATS:
+      handle_timingStats(param);
+      break;
+    case CMD_BURST:
+      handle_burst(param);
+      break;
+    case CMD_SAMPLE_RATE:
+      handle_sampleRate(param);
+      break;
+    case CMD_RELOAD_CONFIG:
+      handle_reloadConfig(param);
+      break;
     case CMD_HARD_RESET:
 #ifdef SFTU
       ESP_LOGI(TAG, "Hard reset command received, resetting system...");
@@ -334,22 +415,19 @@ void Commander::handle_update_spreadingFactor(float sf) { m_loraCom->setSpreadin
 void Commander::handle_update_bandwidthKHz(float bw) { m_loraCom->setBandwidth(bw); }
 
 #ifdef SFTU
+// Kept for the GUI's load cell 1 buttons, CMD_CALIBRATION does the same for any channel
 void Commander::handle_calibrateCell(float massKg) {
-  // FIXME: All this needs to be fixed up
   ESP_LOGD(TAG, "Calibrate cell command executing");
-  float averageVoltage = m_adcADS->getAverageVolt(100, ADS1X15_REG_CONFIG_MUX_DIFF_0_1);  // Read average voltage from ADC
-
-  float force = massKg * 9.81f;  // Convert mass to force in Newtons
-
-  if (m_adcProcessors[0]) {
-    float calibrationResult = m_adcProcessors[0]->calibrate(force, averageVoltage);  // param is the object mass
-    m_serialCom->sendData(String(calibrationResult).c_str());                        // Send the calibration result back
-  } else {
-    ESP_LOGE(TAG, "m_adcProcessors[0] is nullptr!");
-  }
+  char param[32];
+  snprintf(param, sizeof(param), "calibrate 1 %f", massKg * 9.81f);  // mass to force in Newtons
+  handle_calibration(param);
 }
 
-void Commander::handle_setCellScale(float scale) { m_adcProcessors[0]->setScale(scale); }
+void Commander::handle_setCellScale(float scale) {
+  char param[32];
+  snprintf(param, sizeof(param), "scale 1 %f", scale);
+  handle_calibration(param);
+}
 
 void Commander::handle_set_OUTPUT(float indexAndState) {
   // value before decimal is the index, after decimal is the state
@@ -362,6 +440,71 @@ void Commander::handle_set_OUTPUT(float indexAndState) {
   m_actuation->setDigital(PCA6408A_outputPins[outputIndex], (ioState ? OUTPUT_LOW : OUTPUT_OPEN));
 }
 
+void Commander::handle_timingStats(float param) {
+  // param: 0 = report, 1 = report then clear the histogram
+  if (!m_sampleClock) return;
+
+  char buffer[MAX_PAYLOAD_SIZE];
+  m_sampleClock->formatStats(buffer, sizeof(buffer));
+  reply(buffer);
+
+  if (param > 0.5f) m_sampleClock->resetStats();
+}
+
+void Commander::handle_burst(float param) {
+  // param: 0 = report state, 1 = trigger a capture now
+  if (!m_burstCapture) return;
+
+  static const char *stateNames[] = {"disabled", "armed", "post-trigger", "frozen"};
+  const char *state = stateNames[(int)m_burstCapture->state()];
+  if (param > 0.5f && m_burstCapture->state() == BurstCapture::State::ARMED) {
+    m_burstCapture->trigger(BurstTrigger::COMMAND);
+    state = "triggered";
+  }
+
+  char buffer[MAX_PAYLOAD_SIZE];
+  snprintf(buffer, sizeof(buffer), "burst %s, %u records", state, (unsigned)m_burstCapture->capacity());
+  reply(buffer);
+}
+
+void Commander::handle_sampleRate(float param) {
+  // param: log rate in Hz for channels without their own sample_rate, 0 = report the current plan
+  if (!m_planner) return;
+
+  AcquisitionPlan plan;
+  const char *state;
+  if (param <= 0.0f) {
+    plan = m_planner->active();
+    state = "running";
+  } else if (m_planner->plan(param, plan)) {
+    // Applied by the analog task between scans
+    m_planner->request(plan);
+    state = "accepted";
+  } else {
+    char buffer[MAX_PAYLOAD_SIZE];
+    snprintf(buffer, sizeof(buffer), "rate %.1f Hz rejected, the ADCs manage %.1f Hz at most", param, plan.maxLogHz);
+    reply(buffer);
+    return;
+  }
+
+  char buffer[MAX_PAYLOAD_SIZE];
+  int len = snprintf(buffer, sizeof(buffer), "rate %.1f Hz %s: %u SPS, decimation %u, load %.0f%%, cpu %.0f%%", plan.logHz, state, plan.dataRateSps, plan.decimation, plan.load * 100.0f, plan.cpuLoad * 100.0f);
+  if (plan.maxLogHz > 0.0f) {
+    snprintf(buffer + len, sizeof(buffer) - len, ", max %.1f Hz", plan.maxLogHz);
+  } else {
+    snprintf(buffer + len, sizeof(buffer) - len, ", every channel has its own sample_rate");
+  }
+  reply(buffer);
+}
+
+void Commander::handle_reloadConfig(float param) {
+  // Re-read config.json and swap the channels over without stopping acquisition. The SD task
+  // reports back once the new log segment has started, or why it couldn't
+  if (!m_configReload) return;
+  m_configReload->request();
+  reply("config: reload requested");
+}
+
 void Commander::handle_seq(const char *param) {
   ESP_LOGD(TAG, "Sequence command executing");
 
@@ -409,10 +552,121 @@ void Commander::handle_seq(const char *param) {
   }
 }
 
+void Commander::handle_calibration(const char *param) {
+  // param: "tare CH [SAMPLES]", "calibrate CH UNITS [SAMPLES]", "scale CH UNITS_PER_V",
+  //        "point CH UNITS [SAMPLES]", "apply CH", "list CH", "clear CH"
+  // Averages come from the running stream on the analog task, so the reply only says the capture
+  // has started; "list" shows the result once it's done
+  if (!m_calCapture || !param) return;
+
+  char buf[64];
+  strncpy(buf, param, sizeof(buf) - 1);
+  buf[sizeof(buf) - 1] = '\0';
+
+  char *cmd = strtok(buf, " ");
+  char *chStr = strtok(nullptr, " ");
+  char *unitsStr = strtok(nullptr, " ");
+  char *samplesStr = strtok(nullptr, " ");
+
+  char text[MAX_PAYLOAD_SIZE];
+  int channel = chStr ? atoi(chStr) - 1 : -1;
+  if (!cmd || channel < 0 || channel >= 8 || !m_adcProcessors[channel]) {
+    reply("cal: usage tare|calibrate|scale|point|apply|list|clear CH");
+    return;
+  }
+
+  CalibrationPoint points[CalibrationCurve::MAX_POINTS];
+  size_t count = m_calCapture->getPoints(channel, points);
+
+  if (strcmp(cmd, "tare") == 0) {
+    // No units argument, so the sample count is the first one after the channel
+    uint32_t samples = unitsStr ? atoi(unitsStr) : 200;
+    if (m_calCapture->start(channel, CaptureMode::TARE, 0.0f, samples)) {
+      snprintf(text, sizeof(text), "cal CH%d: taring over %u samples", channel + 1, samples);
+    } else {
+      snprintf(text, sizeof(text), "cal CH%d: busy", channel + 1);
+    }
+  } else if ((strcmp(cmd, "calibrate") == 0 || strcmp(cmd, "scale") == 0) && m_adcProcessors[channel]->getCurve().active()) {
+    // The curve maps tared volts to units on its own, a linear scale would be stored and never used
+    snprintf(text, sizeof(text), "cal CH%d: curve active, clear it before a linear %s", channel + 1, cmd);
+  } else if (strcmp(cmd, "calibrate") == 0) {
+    float units = unitsStr ? atof(unitsStr) : 0.0f;
+    uint32_t samples = samplesStr ? atoi(samplesStr) : 200;
+    if (units != 0.0f && m_calCapture->start(channel, CaptureMode::CALIBRATE, units, samples)) {
+      snprintf(text, sizeof(text), "cal CH%d: calibrating to %.3f over %u samples", channel + 1, units, samples);
+    } else {
+      snprintf(text, sizeof(text), "cal CH%d: busy or no load given", channel + 1);
+    }
+  } else if (strcmp(cmd, "scale") == 0) {
+    float scale = unitsStr ? atof(unitsStr) : 0.0f;
+    m_adcProcessors[channel]->setScale(scale);
+    snprintf(text, sizeof(text), "cal CH%d: scale %.3f units/V", channel + 1, scale);
+  } else if (strcmp(cmd, "point") == 0) {
+    float units = unitsStr ? atof(unitsStr) : 0.0f;
+    uint32_t samples = samplesStr ? atoi(samplesStr) : 250;
+    if (m_calCapture->start(channel, CaptureMode::POINT, units, samples)) {
+      snprintf(text, sizeof(text), "cal CH%d: capturing point %u at %.3f over %u samples", channel + 1, (unsigned)count + 1, units, samples);
+    } else {
+      snprintf(text, sizeof(text), "cal CH%d: busy or full (%u points)", channel + 1, (unsigned)count);
+    }
+  } else if (strcmp(cmd, "apply") == 0) {
+    CalibrationCurve curve;
+    if (m_calCapture->busy(channel) || !curve.compileTable(points, count)) {
+      snprintf(text, sizeof(text), "cal CH%d: can't build a table from %u points", channel + 1, (unsigned)count);
+    } else {
+      m_adcProcessors[channel]->setCurve(curve);
+      snprintf(text, sizeof(text), "cal CH%d: applied %u point table", channel + 1, (unsigned)count);
+    }
+  } else if (strcmp(cmd, "list") == 0) {
+    const adcProcessor *processor = m_adcProcessors[channel];
+    int len = snprintf(text, sizeof(text), "cal CH%d%s: offset %.6f V, scale %.3f units/V%s, points", channel + 1, m_calCapture->busy(channel) ? " (capturing)" : "", processor->getOffset(), processor->getScale(),
+                       processor->getCurve().active() ? " (curve active)" : "");
+    for (size_t i = 0; i < count && len < (int)sizeof(text); ++i) {
+      len += snprintf(text + len, sizeof(text) - len, " %.6f=%.3f", points[i].volts, points[i].units);
+    }
+    if (count == 0) snprintf(text + len, sizeof(text) - len, " none");
+  } else if (strcmp(cmd, "clear") == 0) {
+    // Drops the points and the curve, the channel goes back to its linear scale
+    if (m_calCapture->clear(channel)) {
+      CalibrationCurve linear;
+      m_adcProcessors[channel]->setCurve(linear);
+      snprintf(text, sizeof(text), "cal CH%d: cleared", channel + 1);
+    } else {
+      snprintf(text, sizeof(text), "cal CH%d: capture in progress", channel + 1);
+    }
+  } else {
+    snprintf(text, sizeof(text), "cal: unknown command %s", cmd);
+  }
+  reply(text);
+}
+
+void Commander::handle_spectrum(const char *param) {
+  // param: "CH [LENGTH]", LENGTH a power of two up to SpectrumAnalyzer::MAX_LENGTH, 1024 by default
+  if (!m_spectrum || !param) return;
+
+  int channel = atoi(param) - 1;
+  const char *lengthStr = strchr(param, ' ');
+  size_t length = lengthStr ? atoi(lengthStr) : 1024;
+
+  char text[MAX_PAYLOAD_SIZE];
+  if (m_spectrum->start(channel, length)) {
+    snprintf(text, sizeof(text), "spec CH%d: capturing %u samples", channel + 1, (unsigned)length);
+  } else {
+    snprintf(text, sizeof(text), "spec: busy, or bad channel/length (64-%u, power of two)", (unsigned)SpectrumAnalyzer::MAX_LENGTH);
+  }
+  reply(text);
+}
+
 #else
 void Commander::handle_calibrateCell(float massKg) { return; }
 void Commander::handle_set_OUTPUT(float indexAndState) { return; }
 void Commander::handle_setCellScale(float scale) { return; }
+void Commander::handle_timingStats(float param) { return; }
+void Commander::handle_burst(float param) { return; }
+void Commander::handle_sampleRate(float param) { return; }
+void Commander::handle_reloadConfig(float param) { return; }
 void Commander::handle_seq(const char *param) { return; }
+void Commander::handle_calibration(const char *param) { return; }
+void Commander::handle_spectrum(const char *param) { return; }
 
 #endif
\ No newline at end of file
@@ -13,8 +13,15 @@
 #ifdef SFTU
 #include "Definitions.hpp"
 #include "actuation.hpp"
+#include "AcquisitionPlanner.hpp"
 #include "adcADS.hpp"
 #include "adcProcessor.hpp"
+#include "BurnMonitor.hpp"
+#include "BurstCapture.hpp"
+#include "CalibrationCapture.hpp"
+#include "ConfigReload.hpp"
+#include "SampleClock.hpp"
+#include "SpectrumAnalyzer.hpp"
 #include "outputSequencer.hpp"
 
 #endif
@@ -24,7 +31,7 @@
 class Commander {
  public:
 #ifdef SFTU
-  Commander(SerialCom *serialCom, LoRaCom *loraCom, Actuation *actuation, adcADS *adcADS, adcProcessor *adcProcessors[8]);
+  Commander(SerialCom *serialCom, LoRaCom *loraCom, Actuation *actuation, adcADS *adcADS, adcProcessor *adcProcessors[8], SampleClock *sampleClock, BurstCapture *burstCapture, CalibrationCapture *calCapture, SpectrumAnalyzer *spectrum, AcquisitionPlanner *planner, ConfigReload *configReload, BurnMonitor *burnMonitor);
 #else
   Commander(SerialCom *serialCom, LoRaCom *loraCom);
 #endif
@@ -56,8 +63,18 @@ class Commander {
   Actuation *m_actuation;
   adcADS *m_adcADS;
   adcProcessor **m_adcProcessors;
+  SampleClock *m_sampleClock;
+  BurstCapture *m_burstCapture;
+  CalibrationCapture *m_calCapture;
+  SpectrumAnalyzer *m_spectrum;
+  AcquisitionPlanner *m_planner;
+  ConfigReload *m_configReload;
+  BurnMonitor *m_burnMonitor;
 #endif
 
+  // Send a command result back over serial and LoRa
+  void reply(const char *text);
+
   typedef void (Commander::*Handler)();
 
   struct HandlerMap {
@@ -72,8 +89,14 @@ class Commander {
   void handle_calibrateCell(float param);
   void handle_setCellScale(float param);
   void handle_set_OUTPUT(float param);
+  void handle_timingStats(float param);
+  void handle_burst(float param);
+  void handle_sampleRate(float param);
+  void handle_reloadConfig(float param);
 
   void handle_seq(const char *param);
+  void handle_calibration(const char *param);
+  void handle_spectrum(const char *param);
 
   // ----- Command Handlers -----
   void handle_command_help();  // Command handler for "help"
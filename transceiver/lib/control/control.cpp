@@ -151,9 +151,40 @@ void Control::loRaDataTask() {
         StatusPayload payload;
         memcpy(&payload, msg.payload, sizeof(payload));
 
-        String statusMsg = String("status ") + "ID:" + String(msg.senderID) + " RSSI:" + String(payload.rssi) + " battVoltage:" + String(payload.batteryVoltage) + " status:" + String(payload.status) + " IN1:" + String(payload.IN1) + " IN2:" + String(payload.IN2) + " IN3:" + String(payload.IN3) +
-                           " IN4:" + String(payload.IN4) + " IN5:" + String(payload.IN5) + " IN6:" + String(payload.IN6) + " IN7:" + String(payload.IN7) + " IN8:" + String(payload.IN8) + "\n";
+        String statusMsg = String("status ") + "ID:" + String(msg.senderID) + " RSSI:" + String(payload.rssi) + " battVoltage:" + String(payload.batteryVoltage) + " status:" + String(payload.status) + " window:" + String(payload.windowMs);
+        // Summaries for the channels in the mask follow the fixed part, then the derived values. A
+        // short message gets its fixed part shown and nothing else
+        uint8_t numDerived = std::min<uint8_t>(payload.numDerived, MAX_STATUS_DERIVED);
+        if (msg.length >= statusPayloadSize(payload.channelMask, numDerived)) {
+          const uint8_t *tail = msg.payload + sizeof(payload);
+          // mean/min/max/rms, mean first so it still reads as the channel's value
+          for (uint8_t active = payload.channelMask; active; active &= active - 1) {
+            ChannelSummary ch;
+            memcpy(&ch, tail, sizeof(ch));
+            tail += sizeof(ch);
+            statusMsg += " IN" + String(__builtin_ctz(active) + 1) + ":" + String(ch.mean) + "/" + String(ch.min) + "/" + String(ch.max) + "/" + String(ch.rms);
+          }
+          for (int d = 0; d < numDerived; ++d) {
+            float value;
+            memcpy(&value, tail, sizeof(value));
+            tail += sizeof(value);
+            statusMsg += " D" + String(d + 1) + ":" + String(value);
+          }
+        }
+        statusMsg += "\n";
         m_serialCom->sendData(statusMsg.c_str());
+      } else if (msg.type == TYPE_BURN) {
+        BurnPayload payload;
+        memcpy(&payload, msg.payload, sizeof(payload));
+
+        char line[256];
+        snprintf(line, sizeof(line), "burn ID:%d flags:%u sequence:%.2f burnTime:%.3f peakThrust:%.2f peakTime:%.3f impulse:%.2f avgThrust:%.2f peakPressure:%.2f\n", msg.senderID, payload.flags, payload.sequenceS, payload.burnTimeS, payload.peakThrust,
+                 payload.peakThrustTimeS, payload.totalImpulse, payload.averageThrust, payload.peakPressure);
+        m_serialCom->sendData(line);
+      } else if (msg.type == TYPE_TEXT) {
+        msg.payload[sizeof(msg.payload) - 1] = '\0';
+        m_serialCom->sendData(reinterpret_cast<const char *>(msg.payload));
+        m_serialCom->sendData("\n");
       }
       // Clear for the next iteration
       memset(&msg, 0, sizeof(msg));
@@ -172,10 +203,10 @@ void Control::statusTask() {
   msg.senderID = DEVICE_ID;
   msg.receiverID = BROADCAST_ID;
   msg.type = TYPE_STATUS;
-  msg.length = sizeof(StatusPayload);
+  msg.length = statusPayloadSize(0, 0);  // no channels of its own
 
   while (true) {
-    StatusPayload payload;
+    StatusPayload payload = {};
     payload.rssi = static_cast<int8_t>(m_LoRaCom->getRssi());  // value from -128 to 127, this should be fine
     payload.batteryVoltage = m_batteryLevel;
     payload.status = deviceStatus::STATUS_OK;